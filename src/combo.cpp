@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "combo.h"
+
+#ifdef _WIN32
+#define snprintf sprintf_s
+#endif
+
+#define COMBO_ID_BUFSIZE 16
+
+struct Combo {
+    unsigned int number;  /* Ascending, but not contiguous if a combo in the file was invalid */
+    bool sequence;
+    unsigned int count;
+    unsigned int slots[COMBO_MAX_KEYS];
+    char identifier[COMBO_ID_BUFSIZE];
+    std::string text;
+};
+
+static std::vector<Combo> combos;
+static uint64_t comboTimeout = 0;
+static std::atomic<unsigned long long> matchCount(0);
+
+/*
+* Chords are indexed per key in a flat offset table: the chords containing a slot are
+* chordEntries[chordOffsets[slot]] up to chordEntries[chordOffsets[slot + 1]].
+*/
+static std::vector<uint16_t> chordOffsets;
+static std::vector<uint8_t> chordEntries;
+static uint8_t chordPressed[COMBO_MAX_COUNT];
+static bool chordActive[COMBO_MAX_COUNT];
+static uint64_t chordFirstPress[COMBO_MAX_COUNT];
+
+/*
+* Sequences are compiled into a deterministic automaton over the keys they use. Each key maps to a
+* symbol, every state has one transition per symbol and states that complete a sequence output it.
+*/
+static std::vector<uint16_t> sequenceSymbols;      /* Per slot, 0 if no sequence uses the key */
+static unsigned int sequenceSymbolCount = 0;
+static std::vector<uint16_t> sequenceTransitions;  /* [state * sequenceSymbolCount + symbol - 1] */
+static std::vector<uint8_t> sequenceOutputs;       /* Per state, combo + 1 or 0 */
+static uint16_t sequenceState = 0;
+static uint64_t sequenceLastPress = 0;
+static uint8_t sequenceRelease[GKEY_SLOT_COUNT];   /* Combo + 1 to release when the key goes up */
+
+void ComboClear() {
+    combos.clear();
+}
+
+bool ComboAdd(unsigned int number, bool sequence, const unsigned int* slots, unsigned int count, const char* text) {
+    if (combos.size() >= COMBO_MAX_COUNT || count < 2 || count > COMBO_MAX_KEYS)
+        return false;
+    if (number == 0 || number > COMBO_MAX_NUMBER || (!combos.empty() && number <= combos.back().number))
+        return false;
+
+    Combo combo;
+    combo.number = number;
+    combo.sequence = sequence;
+    combo.count = count;
+    for (unsigned int i = 0; i < count; i++) {
+        if (slots[i] >= GKEY_SLOT_COUNT)
+            return false;
+        /* A chord can't contain the same key twice */
+        for (unsigned int j = 0; !sequence && j < i; j++) {
+            if (slots[j] == slots[i])
+                return false;
+        }
+        combo.slots[i] = slots[i];
+    }
+    snprintf(combo.identifier, COMBO_ID_BUFSIZE, COMBO_ID_PREFIX "%u", number);
+    combo.text = text;
+    combos.push_back(combo);
+    return true;
+}
+
+static void CompileChords() {
+    std::vector<uint16_t> counts(GKEY_SLOT_COUNT, 0);
+    for (const Combo& combo : combos) {
+        if (combo.sequence)
+            continue;
+        for (unsigned int i = 0; i < combo.count; i++)
+            counts[combo.slots[i]]++;
+    }
+
+    chordOffsets.assign(GKEY_SLOT_COUNT + 1, 0);
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++)
+        chordOffsets[slot + 1] = chordOffsets[slot] + counts[slot];
+
+    chordEntries.assign(chordOffsets[GKEY_SLOT_COUNT], 0);
+    std::vector<uint16_t> fill(chordOffsets.begin(), chordOffsets.end() - 1);
+    for (unsigned int c = 0; c < combos.size(); c++) {
+        if (combos[c].sequence)
+            continue;
+        for (unsigned int i = 0; i < combos[c].count; i++)
+            chordEntries[fill[combos[c].slots[i]]++] = (uint8_t)c;
+    }
+
+    memset(chordPressed, 0, sizeof(chordPressed));
+    memset(chordActive, 0, sizeof(chordActive));
+    memset(chordFirstPress, 0, sizeof(chordFirstPress));
+}
+
+static void CompileSequences() {
+    sequenceSymbols.assign(GKEY_SLOT_COUNT, 0);
+    sequenceSymbolCount = 0;
+    for (const Combo& combo : combos) {
+        if (!combo.sequence)
+            continue;
+        for (unsigned int i = 0; i < combo.count; i++) {
+            if (!sequenceSymbols[combo.slots[i]])
+                sequenceSymbols[combo.slots[i]] = (uint16_t)++sequenceSymbolCount;
+        }
+    }
+
+    /* Build a trie of all sequences, state 0 being the root */
+    std::vector<int> trie(sequenceSymbolCount, -1);
+    sequenceOutputs.assign(1, 0);
+    for (unsigned int c = 0; c < combos.size(); c++) {
+        if (!combos[c].sequence)
+            continue;
+        unsigned int state = 0;
+        for (unsigned int i = 0; i < combos[c].count; i++) {
+            const unsigned int symbol = sequenceSymbols[combos[c].slots[i]] - 1;
+            if (trie[state * sequenceSymbolCount + symbol] == -1) {
+                trie[state * sequenceSymbolCount + symbol] = (int)sequenceOutputs.size();
+                sequenceOutputs.push_back(0);
+                trie.resize(trie.size() + sequenceSymbolCount, -1);
+            }
+            state = trie[state * sequenceSymbolCount + symbol];
+        }
+        if (!sequenceOutputs[state])
+            sequenceOutputs[state] = (uint8_t)(c + 1);
+    }
+
+    /* Turn the trie into an automaton by following failure links breadth-first, as in Aho-Corasick */
+    const unsigned int states = (unsigned int)sequenceOutputs.size();
+    sequenceTransitions.assign(states * sequenceSymbolCount, 0);
+    std::vector<uint16_t> failure(states, 0);
+    std::vector<uint16_t> queue;
+    for (unsigned int symbol = 0; symbol < sequenceSymbolCount; symbol++) {
+        const int child = trie[symbol];
+        if (child != -1) {
+            sequenceTransitions[symbol] = (uint16_t)child;
+            queue.push_back((uint16_t)child);
+        }
+    }
+    for (size_t i = 0; i < queue.size(); i++) {
+        const unsigned int state = queue[i];
+        if (!sequenceOutputs[state])
+            sequenceOutputs[state] = sequenceOutputs[failure[state]];
+        for (unsigned int symbol = 0; symbol < sequenceSymbolCount; symbol++) {
+            const int child = trie[state * sequenceSymbolCount + symbol];
+            const uint16_t fallback = sequenceTransitions[failure[state] * sequenceSymbolCount + symbol];
+            if (child != -1) {
+                failure[child] = fallback;
+                sequenceTransitions[state * sequenceSymbolCount + symbol] = (uint16_t)child;
+                queue.push_back((uint16_t)child);
+            } else {
+                sequenceTransitions[state * sequenceSymbolCount + symbol] = fallback;
+            }
+        }
+    }
+
+    sequenceState = 0;
+    sequenceLastPress = 0;
+    memset(sequenceRelease, 0, sizeof(sequenceRelease));
+}
+
+void ComboCompile(uint64_t timeout) {
+    comboTimeout = timeout;
+    CompileChords();
+    CompileSequences();
+}
+
+static void ProcessChords(unsigned int slot, bool down, uint64_t timestamp, ComboEmitFunc emit) {
+    for (unsigned int i = chordOffsets[slot]; i < chordOffsets[slot + 1]; i++) {
+        const unsigned int c = chordEntries[i];
+        if (down) {
+            if (chordPressed[c]++ == 0)
+                chordFirstPress[c] = timestamp;
+            if (chordPressed[c] == combos[c].count && timestamp - chordFirstPress[c] <= comboTimeout) {
+                chordActive[c] = true;
+                matchCount.fetch_add(1, std::memory_order_relaxed);
+                emit(c, true, timestamp);
+            }
+        } else {
+            if (chordPressed[c])
+                chordPressed[c]--;
+            if (chordActive[c]) {
+                chordActive[c] = false;
+                emit(c, false, timestamp);
+            }
+        }
+    }
+}
+
+static void ProcessSequences(unsigned int slot, bool down, uint64_t timestamp, ComboEmitFunc emit) {
+    if (!down) {
+        if (sequenceRelease[slot]) {
+            emit(sequenceRelease[slot] - 1, false, timestamp);
+            sequenceRelease[slot] = 0;
+        }
+        return;
+    }
+
+    const unsigned int symbol = sequenceSymbols[slot];
+    if (!symbol || timestamp - sequenceLastPress > comboTimeout)
+        sequenceState = 0;
+    sequenceLastPress = timestamp;
+    if (!symbol)
+        return;
+
+    sequenceState = sequenceTransitions[sequenceState * sequenceSymbolCount + symbol - 1];
+    const unsigned int output = sequenceOutputs[sequenceState];
+    if (output && !sequenceRelease[slot]) {
+        /* The combo stays held for as long as its final key is */
+        sequenceRelease[slot] = (uint8_t)output;
+        sequenceState = 0;
+        matchCount.fetch_add(1, std::memory_order_relaxed);
+        emit(output - 1, true, timestamp);
+    }
+}
+
+void ComboProcess(GkeyCode code, uint64_t timestamp, ComboEmitFunc emit) {
+    if (combos.empty())
+        return;
+
+    const unsigned int slot = GKEY_SLOT(code);
+    ProcessChords(slot, code.keyDown != 0, timestamp, emit);
+    if (sequenceSymbolCount)
+        ProcessSequences(slot, code.keyDown != 0, timestamp, emit);
+}
+
+unsigned int ComboCount() {
+    return (unsigned int)combos.size();
+}
+
+const char* ComboIdentifier(unsigned int combo) {
+    return combos[combo].identifier;
+}
+
+const char* ComboText(unsigned int combo) {
+    return combos[combo].text.c_str();
+}
+
+unsigned long long ComboMatches() {
+    return matchCount.load();
+}
+
+bool ComboParseIdentifier(const char* keyIdentifier, unsigned int* combo) {
+    if (strncmp(keyIdentifier, COMBO_ID_PREFIX, sizeof(COMBO_ID_PREFIX) - 1) != 0)
+        return false;
+
+    const char* p = keyIdentifier + sizeof(COMBO_ID_PREFIX) - 1;
+    unsigned int number = 0;
+    const char* digits = p;
+    while (*p >= '0' && *p <= '9' && p - digits < 3)
+        number = number * 10 + (*p++ - '0');
+    if (p == digits || *p != '\0' || *digits == '0')
+        return false;
+
+    std::vector<Combo>::const_iterator it = std::lower_bound(combos.begin(), combos.end(), number,
+        [](const Combo& c, unsigned int n) { return c.number < n; });
+    if (it == combos.end() || it->number != number)
+        return false;
+
+    *combo = (unsigned int)(it - combos.begin());
+    return true;
+}
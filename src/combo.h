@@ -0,0 +1,39 @@
+#ifndef COMBO_H
+#define COMBO_H
+
+#include <stdint.h>
+#include "gkey.h"
+
+#define COMBO_ID_PREFIX "combo-"
+#define COMBO_MAX_COUNT 64
+#define COMBO_MAX_KEYS 8
+#define COMBO_MAX_NUMBER 999
+
+/* Called for every combo that becomes active or is released */
+typedef void (*ComboEmitFunc)(unsigned int combo, bool down, uint64_t timestamp);
+
+/* Removes all combo definitions */
+void ComboClear();
+
+/*
+* Adds a chord, all keys held at once, or a sequence, keys pressed in order, over the given key slots.
+* It is identified as "combo-N" with the given number, which must be higher than that of the previous combo.
+* The text is used as its display name. Returns false if the combo is invalid or there are too many.
+*/
+bool ComboAdd(unsigned int number, bool sequence, const unsigned int* slots, unsigned int count, const char* text);
+
+/* Builds the transition tables for all added combos, keys must be pressed within timeout nanoseconds */
+void ComboCompile(uint64_t timeout);
+
+/* Feeds a key edge through the combo tables, only called from the dispatcher thread */
+void ComboProcess(GkeyCode code, uint64_t timestamp, ComboEmitFunc emit);
+
+unsigned int ComboCount();
+const char* ComboIdentifier(unsigned int combo);
+const char* ComboText(unsigned int combo);
+unsigned long long ComboMatches();
+
+/* Parses a "combo-N" identifier, returns false if it does not name a defined combo */
+bool ComboParseIdentifier(const char* keyIdentifier, unsigned int* combo);
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "config.h"
+
+#ifdef _WIN32
+#pragma warning (disable : 4996)  /* fopen is fine for a read-only settings file */
+#endif
+
+static const GkeyConfig defaultConfig = {
+    256,    /* queueCapacity */
+    false,  /* dispatcherHighPriority */
+    "",     /* recordFile */
+    "",     /* replayFile */
+    true,   /* replayRealtime */
+    false,  /* stats */
+    0,      /* debounceKeyboard */
+    0,      /* debounceMouse */
+    {},     /* combos */
+    500,    /* comboTimeout */
+    {},     /* pushToTalk */
+    {},     /* toggleInput */
+    GKEY_BACKEND_CALLBACK,  /* backend */
+    2,      /* pollInterval */
+    50,     /* pollIdleInterval */
+    {},     /* evdevDevices */
+    {},     /* evdevMap */
+    false,  /* timeline */
+    16384,  /* timelineSpans */
+    {},     /* repeatKeys */
+    500,    /* repeatDelay */
+    50,     /* repeatInterval */
+    {},     /* tapHold */
+    300,    /* holdTime */
+};
+
+GkeyConfig gkeyConfig = defaultConfig;
+
+typedef bool (*ConfigParser)(const char* value, void* target);
+
+static bool ParseUInt(const char* value, void* target) {
+    char* end;
+    unsigned long result = strtoul(value, &end, 10);
+    if (end == value || *end != '\0')
+        return false;
+    *(unsigned int*)target = (unsigned int)result;
+    return true;
+}
+
+static bool ParseBool(const char* value, void* target) {
+    if (strcmp(value, "1") == 0 || strcmp(value, "true") == 0 || strcmp(value, "yes") == 0)
+        *(bool*)target = true;
+    else if (strcmp(value, "0") == 0 || strcmp(value, "false") == 0 || strcmp(value, "no") == 0)
+        *(bool*)target = false;
+    else
+        return false;
+    return true;
+}
+
+static bool ParsePath(const char* value, void* target) {
+    if (strlen(value) >= GKEY_CONFIG_PATH_SIZE)
+        return false;
+    strcpy((char*)target, value);
+    return true;
+}
+
+static bool ParseAppend(const char* value, void* target) {
+    if (*value == '\0')
+        return false;
+    ((std::vector<std::string>*)target)->push_back(value);
+    return true;
+}
+
+static bool ParseCombo(const char* value, void* target, bool sequence) {
+    if (*value == '\0')
+        return false;
+    const GkeyComboConfig combo = { sequence, value };
+    ((std::vector<GkeyComboConfig>*)target)->push_back(combo);
+    return true;
+}
+
+static bool ParseChord(const char* value, void* target) {
+    return ParseCombo(value, target, false);
+}
+
+static bool ParseSequence(const char* value, void* target) {
+    return ParseCombo(value, target, true);
+}
+
+static bool ParseBackend(const char* value, void* target) {
+    if (strcmp(value, "callback") == 0)
+        *(GkeyBackend*)target = GKEY_BACKEND_CALLBACK;
+    else if (strcmp(value, "poll") == 0)
+        *(GkeyBackend*)target = GKEY_BACKEND_POLL;
+    else if (strcmp(value, "evdev") == 0)
+        *(GkeyBackend*)target = GKEY_BACKEND_EVDEV;
+    else
+        return false;
+    return true;
+}
+
+static const struct {
+    const char* key;
+    ConfigParser parse;
+    void* target;
+} configEntries[] = {
+    { "queue_capacity", ParseUInt, &gkeyConfig.queueCapacity },
+    { "dispatcher_high_priority", ParseBool, &gkeyConfig.dispatcherHighPriority },
+    { "record_file", ParsePath, gkeyConfig.recordFile },
+    { "replay_file", ParsePath, gkeyConfig.replayFile },
+    { "replay_realtime", ParseBool, &gkeyConfig.replayRealtime },
+    { "stats", ParseBool, &gkeyConfig.stats },
+    { "debounce_keyboard_ms", ParseUInt, &gkeyConfig.debounceKeyboard },
+    { "debounce_mouse_ms", ParseUInt, &gkeyConfig.debounceMouse },
+    { "chord", ParseChord, &gkeyConfig.combos },
+    { "sequence", ParseSequence, &gkeyConfig.combos },
+    { "combo_timeout_ms", ParseUInt, &gkeyConfig.comboTimeout },
+    { "push_to_talk", ParseAppend, &gkeyConfig.pushToTalk },
+    { "toggle_input", ParseAppend, &gkeyConfig.toggleInput },
+    { "backend", ParseBackend, &gkeyConfig.backend },
+    { "poll_interval_ms", ParseUInt, &gkeyConfig.pollInterval },
+    { "poll_idle_interval_ms", ParseUInt, &gkeyConfig.pollIdleInterval },
+    { "evdev_device", ParseAppend, &gkeyConfig.evdevDevices },
+    { "evdev_map", ParseAppend, &gkeyConfig.evdevMap },
+    { "timeline", ParseBool, &gkeyConfig.timeline },
+    { "timeline_spans", ParseUInt, &gkeyConfig.timelineSpans },
+    { "repeat", ParseAppend, &gkeyConfig.repeatKeys },
+    { "repeat_delay_ms", ParseUInt, &gkeyConfig.repeatDelay },
+    { "repeat_interval_ms", ParseUInt, &gkeyConfig.repeatInterval },
+    { "tap_hold", ParseAppend, &gkeyConfig.tapHold },
+    { "hold_time_ms", ParseUInt, &gkeyConfig.holdTime },
+};
+
+/* Strips leading and trailing whitespace in place */
+static char* Trim(char* str) {
+    while (isspace((unsigned char)*str))
+        str++;
+    char* end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1]))
+        *--end = '\0';
+    return str;
+}
+
+void ConfigLoad(const char* path) {
+    gkeyConfig = defaultConfig;
+
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return;  /* No settings file, keep the defaults */
+
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        char* key = Trim(line);
+        if (*key == '\0' || *key == '#' || *key == ';' || *key == '[')
+            continue;
+
+        char* value = strchr(key, '=');
+        if (!value)
+            continue;
+        *value++ = '\0';
+        key = Trim(key);
+        value = Trim(value);
+
+        for (size_t i = 0; i < sizeof(configEntries) / sizeof(configEntries[0]); i++) {
+            if (strcmp(key, configEntries[i].key) == 0) {
+                if (!configEntries[i].parse(value, configEntries[i].target))
+                    printf("PLUGIN: Invalid value for %s: %s\n", key, value);
+                break;
+            }
+        }
+    }
+    fclose(file);
+}
@@ -0,0 +1,55 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <vector>
+
+/* Name of the optional settings file inside the TeamSpeak config directory */
+#define GKEY_CONFIG_FILE "gkey_plugin.ini"
+#define GKEY_CONFIG_PATH_SIZE 260
+
+/* A chord or sequence, kept in the order of the file so its combo-N identifier stays the same */
+struct GkeyComboConfig {
+    bool sequence;
+    std::string keys;
+};
+
+enum GkeyBackend {
+    GKEY_BACKEND_CALLBACK,  /* Key events are pushed by the G-key SDK */
+    GKEY_BACKEND_POLL,      /* The pressed state of every key is polled from the G-key SDK */
+    GKEY_BACKEND_EVDEV,     /* Key events are read from Linux event devices */
+};
+
+struct GkeyConfig {
+    unsigned int queueCapacity;   /* queue_capacity: events buffered for the dispatcher, 0 dispatches on the SDK thread */
+    bool dispatcherHighPriority;  /* dispatcher_high_priority: raise the priority of the dispatcher thread */
+    char recordFile[GKEY_CONFIG_PATH_SIZE];  /* record_file: append all key events to this trace file */
+    char replayFile[GKEY_CONFIG_PATH_SIZE];  /* replay_file: replay this trace file instead of listening to the SDK */
+    bool replayRealtime;          /* replay_realtime: keep the original timing of replayed events */
+    bool stats;                   /* stats: collect per-key counters and latency histograms */
+    unsigned int debounceKeyboard;  /* debounce_keyboard_ms: ignore keyboard G-key chatter within this window */
+    unsigned int debounceMouse;   /* debounce_mouse_ms: ignore mouse button chatter within this window */
+    std::vector<GkeyComboConfig> combos;  /* chord, sequence: keys joined by '+' held at once or ',' pressed in order, may repeat */
+    unsigned int comboTimeout;    /* combo_timeout_ms: maximum time between the key presses of a chord or sequence */
+    std::vector<std::string> pushToTalk;   /* push_to_talk: key that activates the microphone while held, may repeat */
+    std::vector<std::string> toggleInput;  /* toggle_input: key that toggles the microphone on every press, may repeat */
+    GkeyBackend backend;          /* backend: where key events come from, "callback", "poll" or "evdev" */
+    unsigned int pollInterval;    /* poll_interval_ms: polling interval while any key is held */
+    unsigned int pollIdleInterval;  /* poll_idle_interval_ms: longest polling interval while no key is held */
+    std::vector<std::string> evdevDevices;  /* evdev_device: event device to read G-keys from, may repeat */
+    std::vector<std::string> evdevMap;      /* evdev_map: "<key code> <identifier>" overriding the default mapping, may repeat */
+    bool timeline;                /* timeline: record a timeline of recent key events in memory */
+    unsigned int timelineSpans;   /* timeline_spans: number of spans kept in the timeline */
+    std::vector<std::string> repeatKeys;  /* repeat: key that is pressed again repeatedly while held, may repeat */
+    unsigned int repeatDelay;     /* repeat_delay_ms: time a key is held before it starts repeating */
+    unsigned int repeatInterval;  /* repeat_interval_ms: time between repeated presses */
+    std::vector<std::string> tapHold;  /* tap_hold: key that acts as separate "-tap" and "-hold" keys, may repeat */
+    unsigned int holdTime;        /* hold_time_ms: time a tap_hold key is held before it counts as held */
+};
+
+extern GkeyConfig gkeyConfig;
+
+/* Resets the configuration to its defaults and applies any "key = value" lines found in the given file */
+void ConfigLoad(const char* path);
+
+#endif
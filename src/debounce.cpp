@@ -0,0 +1,93 @@
+#include <atomic>
+#include "debounce.h"
+
+/* Key states are only touched by the dispatcher thread */
+static uint64_t keyboardWindow = 0, mouseWindow = 0;
+static uint64_t reportedDown[GKEY_SLOT_WORDS];  /* State the client was last told about */
+static uint64_t physicalDown[GKEY_SLOT_WORDS];  /* State the device last reported */
+static uint64_t unsettled[GKEY_SLOT_WORDS];     /* Keys with suppressed edges inside their window */
+static uint64_t edgeTimes[GKEY_SLOT_COUNT];     /* When the reported state last changed */
+
+static std::atomic<unsigned long long> duplicateCount(0), chatterCount(0), settledCount(0);
+
+void DebounceInit(uint64_t keyboard, uint64_t mouse) {
+    keyboardWindow = keyboard;
+    mouseWindow = mouse;
+    memset(reportedDown, 0, sizeof(reportedDown));
+    memset(physicalDown, 0, sizeof(physicalDown));
+    memset(unsettled, 0, sizeof(unsettled));
+    memset(edgeTimes, 0, sizeof(edgeTimes));
+}
+
+bool DebounceFilter(GkeyCode code, uint64_t timestamp) {
+    const unsigned int slot = GKEY_SLOT(code);
+    const unsigned int word = slot / 64;
+    const uint64_t mask = 1ULL << (slot % 64);
+    const bool down = code.keyDown != 0;
+
+    const bool wasDown = (physicalDown[word] & mask) != 0;
+    if (down)
+        physicalDown[word] |= mask;
+    else
+        physicalDown[word] &= ~mask;
+
+    if (down == ((reportedDown[word] & mask) != 0)) {
+        if (down == wasDown)
+            duplicateCount.fetch_add(1, std::memory_order_relaxed);
+        else
+            chatterCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint64_t window = code.mouse ? mouseWindow : keyboardWindow;
+    if (timestamp < edgeTimes[slot] + window) {
+        chatterCount.fetch_add(1, std::memory_order_relaxed);
+        unsettled[word] |= mask;
+        return false;
+    }
+
+    reportedDown[word] ^= mask;
+    edgeTimes[slot] = timestamp;
+    return true;
+}
+
+uint64_t DebounceSettle(uint64_t now, DebounceEmitFunc emit) {
+    uint64_t next = 0;
+    for (unsigned int word = 0; word < GKEY_SLOT_WORDS; word++) {
+        for (uint64_t bits = unsettled[word]; bits; bits &= bits - 1) {
+            unsigned int bit = 0;
+            while (!((bits >> bit) & 1))
+                bit++;
+            const unsigned int slot = word * 64 + bit;
+            const uint64_t mask = 1ULL << bit;
+            const uint64_t deadline = edgeTimes[slot] + (GKEY_SLOT_MOUSE(slot) ? mouseWindow : keyboardWindow);
+
+            if (now < deadline) {
+                if (!next || deadline < next)
+                    next = deadline;
+                continue;
+            }
+
+            unsettled[word] &= ~mask;
+            if ((physicalDown[word] ^ reportedDown[word]) & mask) {
+                reportedDown[word] ^= mask;
+                edgeTimes[slot] = now;
+                settledCount.fetch_add(1, std::memory_order_relaxed);
+                emit(GkeyCodeFromSlot(slot, (reportedDown[word] & mask) != 0), now);
+            }
+        }
+    }
+    return next;
+}
+
+void DebounceGetStats(DebounceStats* stats) {
+    stats->duplicates = duplicateCount.load();
+    stats->chatter = chatterCount.load();
+    stats->settled = settledCount.load();
+}
+
+void DebounceResetStats() {
+    duplicateCount.store(0);
+    chatterCount.store(0);
+    settledCount.store(0);
+}
@@ -0,0 +1,33 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include "gkey.h"
+
+struct DebounceStats {
+    unsigned long long duplicates;  /* Edges repeating the state the key was already in */
+    unsigned long long chatter;     /* Edges suppressed because they arrived within the debounce window */
+    unsigned long long settled;     /* Edges emitted after the window closed with the key in a different state */
+};
+
+typedef void (*DebounceEmitFunc)(GkeyCode code, uint64_t timestamp);
+
+/* Resets all key states and sets the debounce windows in nanoseconds, 0 only suppresses duplicate edges */
+void DebounceInit(uint64_t keyboardWindow, uint64_t mouseWindow);
+
+/*
+* Returns whether an event changes the reported state of its key and should be passed on. The first edge
+* is always passed immediately, further edges within the window only update the physical state.
+*/
+bool DebounceFilter(GkeyCode code, uint64_t timestamp);
+
+/*
+* Emits the physical state of every key whose window has closed while it differed from the reported state.
+* Returns the timestamp of the next window to close, or 0 if none are pending.
+*/
+uint64_t DebounceSettle(uint64_t now, DebounceEmitFunc emit);
+
+void DebounceGetStats(DebounceStats* stats);
+void DebounceResetStats();
+
+#endif
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include "dispatcher.h"
+#include "event_queue.h"
+
+#ifndef _WIN32
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static EventQueue queue;
+static GkeyDispatchFunc dispatchFunc = NULL;
+static GkeyTickFunc tickFunc = NULL;
+static std::thread dispatcherThread;
+static std::atomic<bool> running(false);
+static std::atomic<bool> stopping(false);
+
+/* Wakeup handshake, the producer only takes the mutex when the dispatcher is actually waiting */
+static std::mutex wakeMutex;
+static std::condition_variable wakeCond;
+static std::atomic<bool> sleeping(false);
+
+/* Keys the producer delivered a key-down for, only touched by the producer thread */
+static uint64_t heldKeys[GKEY_SLOT_WORDS];
+
+/* Key-ups that did not fit in the queue and must be delivered once it has been drained */
+static std::atomic<uint64_t> pendingUps[GKEY_SLOT_WORDS];
+static std::atomic<bool> hasPendingUps(false);
+
+static std::atomic<unsigned long long> enqueuedCount(0), dispatchedCount(0), droppedCount(0), deferredUpCount(0), orphanUpCount(0);
+static std::atomic<size_t> maxDepth(0);
+static std::atomic<uint64_t> totalLatency(0), maxLatency(0);
+
+static void Deliver(GkeyCode code, uint64_t timestamp) {
+    const uint64_t latency = GkeyTimestamp() - timestamp;
+    totalLatency.fetch_add(latency, std::memory_order_relaxed);
+    AtomicMax(maxLatency, latency);
+    dispatchedCount.fetch_add(1, std::memory_order_relaxed);
+
+    dispatchFunc(code, timestamp);
+}
+
+static void DeliverPendingUps() {
+    if (!hasPendingUps.exchange(false, std::memory_order_acq_rel))
+        return;
+
+    const uint64_t timestamp = GkeyTimestamp();
+    for (unsigned int word = 0; word < GKEY_SLOT_WORDS; word++) {
+        uint64_t bits = pendingUps[word].exchange(0, std::memory_order_acq_rel);
+        for (unsigned int bit = 0; bits; bit++, bits >>= 1) {
+            if (!(bits & 1))
+                continue;
+            deferredUpCount.fetch_add(1, std::memory_order_relaxed);
+            Deliver(GkeyCodeFromSlot(word * 64 + bit, false), timestamp);
+        }
+    }
+}
+
+static void DispatcherRun() {
+    for (;;) {
+        GkeyEvent event;
+        while (queue.pop(&event))
+            Deliver(GkeyCodeFromRaw(event.code), event.timestamp);
+        DeliverPendingUps();
+        const uint64_t deadline = tickFunc ? tickFunc(GkeyTimestamp()) : 0;
+
+        if (stopping.load() && queue.size() == 0 && !hasPendingUps.load())
+            break;
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto wakeup = [] { return queue.size() != 0 || hasPendingUps.load() || stopping.load(); };
+        if (deadline) {
+            const std::chrono::steady_clock::time_point until(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(deadline)));
+            wakeCond.wait_until(lock, until, wakeup);
+        } else {
+            wakeCond.wait(lock, wakeup);
+        }
+        sleeping.store(false);
+    }
+}
+
+static void Wake() {
+    if (sleeping.load()) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCond.notify_one();
+    }
+}
+
+bool DispatcherStart(size_t capacity, bool highPriority, GkeyDispatchFunc func, GkeyTickFunc tick) {
+    dispatchFunc = func;
+    tickFunc = tick;
+    memset(heldKeys, 0, sizeof(heldKeys));
+    for (unsigned int word = 0; word < GKEY_SLOT_WORDS; word++)
+        pendingUps[word].store(0);
+    hasPendingUps.store(false);
+    stopping.store(false);
+
+    if (capacity == 0 || !queue.init(capacity))
+        return false;
+
+    try {
+        dispatcherThread = std::thread(DispatcherRun);
+    }
+    catch (const std::system_error&) {
+        printf("PLUGIN: Failed to start the dispatcher thread, dispatching synchronously\n");
+        return false;
+    }
+
+    if (highPriority) {
+#ifdef _WIN32
+        SetThreadPriority(dispatcherThread.native_handle(), THREAD_PRIORITY_HIGHEST);
+#else
+        /* The lowest real-time priority is enough to run ahead of every normal thread, it needs CAP_SYS_NICE or an rtprio limit */
+        struct sched_param param;
+        param.sched_priority = sched_get_priority_min(SCHED_RR);
+        const int error = pthread_setschedparam(dispatcherThread.native_handle(), SCHED_RR, &param);
+        if (error)
+            printf("PLUGIN: Failed to raise the dispatcher thread priority: %s\n", strerror(error));
+#endif
+    }
+    running.store(true);
+    return true;
+}
+
+void DispatcherStop() {
+    if (!running.exchange(false))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping.store(true);
+        wakeCond.notify_one();
+    }
+    dispatcherThread.join();
+}
+
+void DispatcherEnqueue(GkeyCode code) {
+    enqueuedCount.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t timestamp = GkeyTimestamp();
+    if (!running.load(std::memory_order_acquire)) {
+        Deliver(code, timestamp);
+        return;
+    }
+
+    const unsigned int slot = GKEY_SLOT(code);
+    const uint64_t mask = 1ULL << (slot % 64);
+    uint64_t& held = heldKeys[slot / 64];
+
+    /*
+    * While a deferred key-up is outstanding the key is treated as released so nothing can overtake it,
+    * and a key-up is only passed on if its key-down was.
+    */
+    if ((pendingUps[slot / 64].load(std::memory_order_acquire) & mask) || (!code.keyDown && !(held & mask))) {
+        (code.keyDown ? droppedCount : orphanUpCount).fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    GkeyEvent event = { GkeyCodeToRaw(code), 0, timestamp };
+    if (queue.push(event)) {
+        if (code.keyDown)
+            held |= mask;
+        else
+            held &= ~mask;
+        AtomicMax(maxDepth, queue.size());
+    }
+    else if (!code.keyDown) {
+        held &= ~mask;
+        pendingUps[slot / 64].fetch_or(mask, std::memory_order_acq_rel);
+        hasPendingUps.store(true, std::memory_order_release);
+    }
+    else {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Wake();
+}
+
+void DispatcherGetStats(DispatcherStats* stats) {
+    stats->enqueued = enqueuedCount.load();
+    stats->dispatched = dispatchedCount.load();
+    stats->dropped = droppedCount.load();
+    stats->deferredUps = deferredUpCount.load();
+    stats->orphanUps = orphanUpCount.load();
+    stats->maxDepth = maxDepth.load();
+    stats->totalLatency = totalLatency.load();
+    stats->maxLatency = maxLatency.load();
+}
+
+void DispatcherResetStats() {
+    enqueuedCount.store(0);
+    dispatchedCount.store(0);
+    droppedCount.store(0);
+    deferredUpCount.store(0);
+    orphanUpCount.store(0);
+    maxDepth.store(0);
+    totalLatency.store(0);
+    maxLatency.store(0);
+}
@@ -0,0 +1,47 @@
+#ifndef DISPATCHER_H
+#define DISPATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gkey.h"
+
+/* Called on the dispatcher thread for every event, in the order they were enqueued */
+typedef void (*GkeyDispatchFunc)(GkeyCode code, uint64_t timestamp);
+
+/*
+* Called on the dispatcher thread after every batch of events and whenever the previously returned deadline
+* passes. Returns the GkeyTimestamp() at which it wants to be called again, or 0 if it has nothing pending.
+*/
+typedef uint64_t (*GkeyTickFunc)(uint64_t now);
+
+struct DispatcherStats {
+    unsigned long long enqueued;
+    unsigned long long dispatched;
+    unsigned long long dropped;       /* Events dropped because the queue was full */
+    unsigned long long deferredUps;   /* Key-ups of held keys delivered after an overflow */
+    unsigned long long orphanUps;     /* Key-ups ignored because their key-down was never delivered */
+    size_t maxDepth;
+    uint64_t totalLatency;            /* Sum of enqueue-to-dispatch latencies in nanoseconds */
+    uint64_t maxLatency;
+};
+
+/*
+* Starts the dispatcher thread with a queue of the given capacity. With a capacity of 0, or if the thread
+* could not be started, events are dispatched directly on the thread that enqueues them and the tick
+* function is never called. Returns whether the dispatcher thread is running.
+*/
+bool DispatcherStart(size_t capacity, bool highPriority, GkeyDispatchFunc func, GkeyTickFunc tick);
+
+/* Delivers all queued events and joins the dispatcher thread */
+void DispatcherStop();
+
+/*
+* Queues a key event, must always be called from the same thread. When the queue is full key-downs are
+* dropped together with their key-up, but the key-up of a key that was already delivered is never lost.
+*/
+void DispatcherEnqueue(GkeyCode code);
+
+void DispatcherGetStats(DispatcherStats* stats);
+void DispatcherResetStats();
+
+#endif
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <atomic>
+#include "evdev.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <system_error>
+#include <thread>
+
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+#ifndef KEY_MACRO1
+#define KEY_MACRO1 0x290
+#endif
+#ifndef KEY_MACRO_PRESET1
+#define KEY_MACRO_PRESET1 0x2b3
+#define KEY_MACRO_PRESET2 0x2b4
+#define KEY_MACRO_PRESET3 0x2b5
+#endif
+
+#define EVDEV_MAX_DEVICES 16
+#define EVDEV_BATCH_SIZE 64
+#define EVDEV_MACRO_KEYS 30
+#define EVDEV_FIRST_MOUSE_BUTTON 6
+
+/* Key codes map to a slot + 1, or to a G-key index with the M-state filled in at runtime */
+#define EVDEV_UNMAPPED 0
+#define EVDEV_GKEY_FLAG 0x8000
+
+struct EvdevDevice {
+    int fd;
+    unsigned int gkeyDevice;  /* Device index its keys are reported on */
+    bool timestamps;  /* Whether the input_event times are on our monotonic clock */
+    bool watched;     /* Whether the file descriptor is registered with epoll */
+    size_t pending;   /* Bytes of a partial record left over from the previous read */
+    unsigned char buffer[EVDEV_BATCH_SIZE * sizeof(struct input_event)];
+    uint16_t pressedSlots[KEY_CNT];  /* Slot + 1 each held key was reported as, so its key-up matches */
+};
+
+/* Mapped slots are on device 0 and get moved to the device index of the event device they came from */
+static uint16_t keyMap[KEY_CNT];
+static unsigned int mStates[GKEY_DEVICE_COUNT];
+
+static EvdevDevice devices[EVDEV_MAX_DEVICES];
+static unsigned int deviceCount = 0;
+static int epollFd = -1;
+static int stopFd = -1;
+static std::thread evdevThread;
+static EvdevInputFunc inputFunc = NULL;
+
+static std::atomic<unsigned long long> readCount(0), eventCount(0), keyEventCount(0), latencySamples(0);
+static std::atomic<uint64_t> totalLatency(0), maxLatency(0);
+
+void EvdevResetMap() {
+    memset(keyMap, 0, sizeof(keyMap));
+    for (unsigned int i = 0; i < EVDEV_MACRO_KEYS; i++)
+        keyMap[KEY_MACRO1 + i] = (uint16_t)(EVDEV_GKEY_FLAG | (i + 1));
+
+    GkeyCode code = { 0 };
+    code.mouse = 1;
+    for (unsigned int button = BTN_SIDE; button <= BTN_TASK; button++) {
+        code.keyIdx = EVDEV_FIRST_MOUSE_BUTTON + (button - BTN_SIDE);
+        keyMap[button] = (uint16_t)(GKEY_SLOT(code) + 1);
+    }
+}
+
+bool EvdevMapKey(unsigned int keyCode, unsigned int slot) {
+    if (keyCode >= KEY_CNT || slot >= GKEY_DEVICE_SLOTS)
+        return false;
+    keyMap[keyCode] = (uint16_t)(slot + 1);
+    return true;
+}
+
+static void HandleEvent(EvdevDevice* device, const struct input_event& event) {
+    if (event.type != EV_KEY || event.code >= KEY_CNT || event.value == 2)
+        return;  /* Only presses and releases, autorepeat is left to the client */
+
+    if (event.code >= KEY_MACRO_PRESET1 && event.code <= KEY_MACRO_PRESET3) {
+        if (event.value)
+            mStates[device->gkeyDevice] = event.code - KEY_MACRO_PRESET1 + 1;
+        return;
+    }
+
+    unsigned int slot;
+    if (event.value) {
+        const uint16_t mapping = keyMap[event.code];
+        if (mapping == EVDEV_UNMAPPED)
+            return;
+        if (mapping & EVDEV_GKEY_FLAG) {
+            GkeyCode code = { 0 };
+            code.keyIdx = mapping & 0xFF;
+            code.mState = mStates[device->gkeyDevice];
+            slot = GKEY_SLOT(code);
+        } else {
+            slot = mapping - 1;
+        }
+        slot += device->gkeyDevice * GKEY_DEVICE_SLOTS;
+        device->pressedSlots[event.code] = (uint16_t)(slot + 1);
+    } else {
+        if (!device->pressedSlots[event.code])
+            return;
+        slot = device->pressedSlots[event.code] - 1;
+        device->pressedSlots[event.code] = 0;
+    }
+
+    keyEventCount.fetch_add(1, std::memory_order_relaxed);
+    inputFunc(GkeyCodeFromSlot(slot, event.value != 0));
+}
+
+/* Reads one batch of records, returns 1 if there was data, 0 if there is none right now and -1 at the end */
+static int ReadDevice(EvdevDevice* device) {
+    const ssize_t size = read(device->fd, device->buffer + device->pending, sizeof(device->buffer) - device->pending);
+    if (size < 0)
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    if (size == 0)
+        return -1;
+    readCount.fetch_add(1, std::memory_order_relaxed);
+
+    const size_t available = device->pending + (size_t)size;
+    const size_t count = available / sizeof(struct input_event);
+    const uint64_t now = GkeyTimestamp();
+    for (size_t i = 0; i < count; i++) {
+        struct input_event event;
+        memcpy(&event, device->buffer + i * sizeof(event), sizeof(event));
+
+        if (device->timestamps && event.type == EV_KEY) {
+            const uint64_t time = (uint64_t)event.input_event_sec * 1000000000ULL + (uint64_t)event.input_event_usec * 1000ULL;
+            if (time <= now) {
+                const uint64_t latency = now - time;
+                totalLatency.fetch_add(latency, std::memory_order_relaxed);
+                latencySamples.fetch_add(1, std::memory_order_relaxed);
+                AtomicMax(maxLatency, latency);
+            }
+        }
+        HandleEvent(device, event);
+    }
+    eventCount.fetch_add(count, std::memory_order_relaxed);
+
+    /* Pipes may split a record, keep the remainder for the next read */
+    device->pending = available - count * sizeof(struct input_event);
+    memmove(device->buffer, device->buffer + count * sizeof(struct input_event), device->pending);
+    return 1;
+}
+
+static void EvdevRun() {
+    /* Regular files can't be watched, they hold a recording that is read in one go */
+    for (unsigned int i = 0; i < deviceCount; i++) {
+        if (!devices[i].watched) {
+            while (ReadDevice(&devices[i]) > 0);
+            close(devices[i].fd);
+            devices[i].fd = -1;
+        }
+    }
+
+    struct epoll_event events[EVDEV_MAX_DEVICES + 1];
+    for (;;) {
+        const int ready = epoll_wait(epollFd, events, EVDEV_MAX_DEVICES + 1, -1);
+        if (ready < 0 && errno != EINTR)
+            return;
+
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.ptr == NULL)
+                return;  /* Woken up by EvdevStop */
+
+            EvdevDevice* device = (EvdevDevice*)events[i].data.ptr;
+            int result;
+            while ((result = ReadDevice(device)) > 0);
+            if (result < 0) {
+                /* The device was unplugged or the writing end of the pipe closed */
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, device->fd, NULL);
+                close(device->fd);
+                device->fd = -1;
+            }
+        }
+    }
+}
+
+bool EvdevStart(const char* const* paths, const unsigned int* gkeyDevices, unsigned int count, EvdevInputFunc input) {
+    if (epollFd != -1)
+        return false;
+
+    inputFunc = input;
+    for (unsigned int i = 0; i < GKEY_DEVICE_COUNT; i++)
+        mStates[i] = 1;
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd == -1 || stopFd == -1) {
+        EvdevStop();
+        return false;
+    }
+
+    struct epoll_event stopEvent;
+    stopEvent.events = EPOLLIN;
+    stopEvent.data.ptr = NULL;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &stopEvent);
+
+    deviceCount = 0;
+    for (unsigned int i = 0; i < count && deviceCount < EVDEV_MAX_DEVICES; i++) {
+        EvdevDevice* device = &devices[deviceCount];
+        device->fd = open(paths[i], O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (device->fd == -1) {
+            printf("PLUGIN: Failed to open %s\n", paths[i]);
+            continue;
+        }
+        device->gkeyDevice = gkeyDevices[i] < GKEY_DEVICE_COUNT ? gkeyDevices[i] : 0;
+        device->pending = 0;
+        memset(device->pressedSlots, 0, sizeof(device->pressedSlots));
+
+        /* Compare event times against our own clock, this fails for anything but an event device */
+        int clock = CLOCK_MONOTONIC;
+        device->timestamps = ioctl(device->fd, EVIOCSCLOCKID, &clock) == 0;
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = device;
+        device->watched = epoll_ctl(epollFd, EPOLL_CTL_ADD, device->fd, &event) == 0;
+        deviceCount++;
+    }
+
+    if (deviceCount == 0) {
+        EvdevStop();
+        return false;
+    }
+
+    try {
+        evdevThread = std::thread(EvdevRun);
+    }
+    catch (const std::system_error&) {
+        printf("PLUGIN: Failed to start the evdev thread\n");
+        EvdevStop();
+        return false;
+    }
+    return true;
+}
+
+void EvdevStop() {
+    if (evdevThread.joinable()) {
+        const uint64_t value = 1;
+        if (write(stopFd, &value, sizeof(value)) == sizeof(value))
+            evdevThread.join();
+        else
+            evdevThread.detach();
+    }
+
+    for (unsigned int i = 0; i < deviceCount; i++) {
+        if (devices[i].fd != -1)
+            close(devices[i].fd);
+    }
+    deviceCount = 0;
+
+    if (stopFd != -1)
+        close(stopFd);
+    if (epollFd != -1)
+        close(epollFd);
+    stopFd = epollFd = -1;
+}
+#else
+void EvdevResetMap() {
+}
+
+bool EvdevMapKey(unsigned int keyCode, unsigned int slot) {
+    return false;
+}
+
+bool EvdevStart(const char* const* paths, const unsigned int* gkeyDevices, unsigned int count, EvdevInputFunc input) {
+    return false;
+}
+
+void EvdevStop() {
+}
+
+static std::atomic<unsigned long long> readCount(0), eventCount(0), keyEventCount(0), latencySamples(0);
+static std::atomic<uint64_t> totalLatency(0), maxLatency(0);
+#endif
+
+void EvdevGetStats(EvdevStats* stats) {
+    stats->reads = readCount.load();
+    stats->events = eventCount.load();
+    stats->keyEvents = keyEventCount.load();
+    stats->totalLatency = totalLatency.load();
+    stats->maxLatency = maxLatency.load();
+    stats->latencySamples = latencySamples.load();
+}
+
+void EvdevResetStats() {
+    readCount.store(0);
+    eventCount.store(0);
+    keyEventCount.store(0);
+    totalLatency.store(0);
+    maxLatency.store(0);
+    latencySamples.store(0);
+}
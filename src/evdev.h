@@ -0,0 +1,42 @@
+#ifndef EVDEV_H
+#define EVDEV_H
+
+#include <stdint.h>
+#include "gkey.h"
+
+struct EvdevStats {
+    unsigned long long reads;       /* read() calls that returned data */
+    unsigned long long events;      /* input_event records read */
+    unsigned long long keyEvents;   /* Records mapped to a G-key edge */
+    uint64_t totalLatency;          /* Sum of kernel-to-plugin latencies in nanoseconds, devices only */
+    uint64_t maxLatency;
+    unsigned long long latencySamples;
+};
+
+typedef void (*EvdevInputFunc)(GkeyCode code);
+
+/*
+* Restores the default key mapping: KEY_MACRO1 and up map to keyboard G-keys in the M-state selected by
+* KEY_MACRO_PRESET1 to 3, the extra mouse buttons from BTN_SIDE on map to mouse buttons 6 and up.
+*/
+void EvdevResetMap();
+
+/*
+* Maps an evdev key code to a fixed key slot of device 0, which is reported on the device index of the event
+* device the key was pressed on. Returns false if the code or slot is out of range.
+*/
+bool EvdevMapKey(unsigned int keyCode, unsigned int slot);
+
+/*
+* Watches the given event devices from a background thread and feeds their key events to the input function,
+* reporting the keys of each on the given device index. Pipes and regular files holding recorded input_event
+* streams are accepted as well, files are read once.
+* Only available on Linux, returns false elsewhere or if none of the paths could be opened.
+*/
+bool EvdevStart(const char* const* paths, const unsigned int* gkeyDevices, unsigned int count, EvdevInputFunc input);
+void EvdevStop();
+
+void EvdevGetStats(EvdevStats* stats);
+void EvdevResetStats();
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+
+/* Compact key event handed from the input thread to the dispatcher */
+struct GkeyEvent {
+    uint32_t code;       /* Raw GkeyCode bits */
+    uint32_t reserved;
+    uint64_t timestamp;  /* GkeyTimestamp() of when the event entered the plugin */
+};
+
+/*
+* Bounded lock-free ring buffer. Only safe with exactly one producer and one consumer thread.
+* The capacity is rounded up to a power of two so indices can be masked instead of wrapped.
+*/
+class EventQueue {
+public:
+    EventQueue() : buffer(NULL), mask(0), head(0), tail(0) {}
+    ~EventQueue() { free(buffer); }
+
+    bool init(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+
+        free(buffer);
+        buffer = (GkeyEvent*)malloc(size * sizeof(GkeyEvent));
+        mask = buffer ? size - 1 : 0;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        return buffer != NULL;
+    }
+
+    /* Producer side, returns false if the queue is full */
+    bool push(const GkeyEvent& event) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask)
+            return false;
+        buffer[t & mask] = event;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Consumer side, returns false if the queue is empty */
+    bool pop(GkeyEvent* event) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        *event = buffer[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return buffer ? mask + 1 : 0;
+    }
+
+private:
+    EventQueue(const EventQueue&);
+    EventQueue& operator=(const EventQueue&);
+
+    GkeyEvent* buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;  /* Written by the consumer */
+    alignas(64) std::atomic<size_t> tail;  /* Written by the producer */
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef GKEY_H
+#define GKEY_H
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#define __cdecl
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+
+#include "LogitechGkeyLib.h"
+
+/*
+* Every GkeyCode maps onto a dense slot made up of the device index, the mouse flag, the 8-bit key index and
+* the 2-bit M-state. The SDK only knows a single keyboard and mouse, which are device 0. Other backends keep
+* the index of additional devices in the reserved bits of the GkeyCode.
+*/
+#define GKEY_DEVICE_COUNT 4
+#define GKEY_DEVICE_SLOTS (2 * 256 * 4)
+#define GKEY_SLOT_COUNT (GKEY_DEVICE_COUNT * GKEY_DEVICE_SLOTS)
+#define GKEY_SLOT_WORDS (GKEY_SLOT_COUNT / 64)  /* 64-bit words in a bitmap with one bit per slot */
+#define GKEY_DEVICE(code) ((code).reserved1 & (GKEY_DEVICE_COUNT - 1))
+#define GKEY_SLOT(code) ((GKEY_DEVICE(code) << 11) | ((code).mouse << 10) | ((code).keyIdx << 2) | (code).mState)
+#define GKEY_SLOT_DEVICE(slot) ((slot) >> 11)
+#define GKEY_SLOT_MOUSE(slot) (((slot) >> 10) & 1)
+
+static_assert(sizeof(GkeyCode) == sizeof(uint32_t), "GkeyCode is expected to be a 32-bit bitfield");
+
+static inline uint32_t GkeyCodeToRaw(GkeyCode code) {
+    uint32_t raw;
+    memcpy(&raw, &code, sizeof(raw));
+    return raw;
+}
+
+static inline GkeyCode GkeyCodeFromRaw(uint32_t raw) {
+    GkeyCode code;
+    memcpy(&code, &raw, sizeof(code));
+    return code;
+}
+
+static inline GkeyCode GkeyCodeFromSlot(unsigned int slot, bool keyDown) {
+    GkeyCode code = { 0 };
+    code.reserved1 = GKEY_SLOT_DEVICE(slot);
+    code.mouse = GKEY_SLOT_MOUSE(slot);
+    code.keyIdx = (slot >> 2) & 0xFF;
+    code.mState = slot & 0x3;
+    code.keyDown = keyDown ? 1 : 0;
+    return code;
+}
+
+/* Raises a statistics maximum that may be updated from several threads */
+template <typename T>
+static inline void AtomicMax(std::atomic<T>& target, T value) {
+    T current = target.load(std::memory_order_relaxed);
+    while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+/* Monotonic timestamp in nanoseconds, used to measure event latencies */
+static inline uint64_t GkeyTimestamp() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
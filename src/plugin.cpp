@@ -7,6 +7,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include "teamspeak/public_errors.h"
 #include "teamspeak/public_errors_rare.h"
 #include "teamspeak/public_definitions.h"
@@ -14,42 +17,483 @@
 #include "teamspeak/clientlib_publicdefinitions.h"
 #include "ts3_functions.h"
 #include "plugin.h"
+#include "gkey.h"
+#include "config.h"
+#include "dispatcher.h"
+#include "debounce.h"
+#include "timer_wheel.h"
+#include "combo.h"
+#include "sdk_loader.h"
+#include "poller.h"
+#include "evdev.h"
+#include "recorder.h"
+#include "stats.h"
+#include "timeline.h"
+#include "quiescence.h"
 
 #include "LogitechGkeyLib.h"
+#ifdef _MSC_VER
 #pragma comment(lib, "LogitechGkeyLib.lib")
+#endif
 
 static struct TS3Functions ts3Functions;
 
 #ifdef _WIN32
 #define _strcpy(dest, destSize, src) strcpy_s(dest, destSize, src)
-#define _strtok(cntx, delim) strtok_s(cntx, delim, &cntx)
 #define snprintf sprintf_s
 #else
 #define _strcpy(dest, destSize, src) { strncpy(dest, src, destSize-1); (dest)[destSize-1] = '\0'; }
-#define _strtok(cntx, delim) strtok(cntx, delim)
 #endif
 
 #define PLUGIN_API_VERSION 26
 
-#define GKEY_ID_BUFSIZE 64
+#define PATH_BUFSIZE 512
+#define GKEY_ID_BUFSIZE 16  /* Longest identifier is "keybd4-g255-m3" */
 #define GKEY_MOUSE_ID "mouse"
 #define GKEY_KEYBOARD_ID "keybd"
+#define GKEY_TAP_SUFFIX "-tap"
+#define GKEY_HOLD_SUFFIX "-hold"
+#define GKEY_COMMAND_KEYWORD "gkey"
+#define GKEY_TIMELINE_FILE "gkey_timeline.json"
 
 static char* pluginID = NULL;
 
+/* Default file the timeline is written to, inside the TeamSpeak config directory */
+static char timelinePath[PATH_BUFSIZE];
+
+/* Guards the plugin state against SDK callbacks that are still running while the plugin shuts down */
+static QuiescenceGate sdkCallbackGate;
+
+/* Server connection the direct input actions apply to */
+static std::atomic<uint64> currentServerConnection(0);
+
+/* Actions for keys that change the input state directly instead of going through the client hotkeys */
+enum GkeyAction {
+    GKEY_ACTION_NONE = 0,
+    GKEY_ACTION_PUSH_TO_TALK,
+    GKEY_ACTION_TOGGLE_INPUT,
+};
+static uint8_t gkeyActions[GKEY_SLOT_COUNT];
+
+/* Push-to-talk keys and the connection each one activated, released on that connection even if the tab changed */
+static std::vector<unsigned int> pushToTalkSlots;
+static std::atomic<uint64> pushToTalkConnections[GKEY_SLOT_COUNT];
+
+/* Keys whose events are shaped by timers on the dispatcher thread */
+enum GkeyTimerMode {
+    GKEY_TIMER_NONE = 0,
+    GKEY_TIMER_REPEAT,
+    GKEY_TIMER_TAP_HOLD,
+};
+static uint8_t gkeyTimerModes[GKEY_SLOT_COUNT];
+
+/* Identifiers of the tap and hold halves of tap_hold keys, indexed through gkeyTapHoldIndex */
+struct GkeyTapHoldIds {
+    char tap[GKEY_ID_BUFSIZE + sizeof(GKEY_TAP_SUFFIX) - 1];
+    char hold[GKEY_ID_BUFSIZE + sizeof(GKEY_HOLD_SUFFIX) - 1];
+};
+static std::vector<GkeyTapHoldIds> gkeyTapHoldIds;
+static uint16_t gkeyTapHoldIndex[GKEY_SLOT_COUNT];
+
+/* Identifiers for every possible GkeyCode, built once so the callback never has to format one */
+static char gkeyIdentifiers[GKEY_SLOT_COUNT][GKEY_ID_BUFSIZE];
+static char gkeyDeviceNames[GKEY_DEVICE_COUNT][2][32];
+static const char* const gkeyComboDeviceName = "Logitech G-Key Combo";
+
+/*
+* UTF-8 display names per slot, filled lazily by ts3plugin_displayKeyText. Names that are invalidated are retired
+* instead of freed so any pointer handed to the client stays valid until the plugin shuts down.
+*/
+static std::atomic<char*> gkeyDisplayNames[GKEY_SLOT_COUNT];
+static std::atomic<char*> gkeyTapHoldNames[2][GKEY_SLOT_COUNT];  /* The key's display name with the tap or hold suffix */
+static std::vector<char*> gkeyRetiredNames;
+static std::mutex gkeyRetiredNamesMutex;
+static std::atomic<unsigned long long> displayNameHits(0), displayNameMisses(0), displayNameFallbacks(0);
+
+/* Time spent inside ts3plugin_init, the client's startup waits for this */
+static uint64_t initDuration = 0;
+
 #ifdef _WIN32
 /* Helper function to convert wchar_T to Utf-8 encoded strings on Windows */
 static int wcharToUtf8(const wchar_t* str, char** result) {
     int outlen = WideCharToMultiByte(CP_UTF8, 0, str, -1, 0, 0, 0, 0);
     *result = (char*)malloc(outlen);
     if (WideCharToMultiByte(CP_UTF8, 0, str, -1, *result, outlen, 0, 0) == 0) {
+        free(*result);
         *result = NULL;
         return -1;
     }
     return 0;
 }
+#else
+/* Helper function to convert wchar_t to Utf-8 encoded strings, outside of Windows wchar_t holds UTF-32 */
+static int wcharToUtf8(const wchar_t* str, char** result) {
+    size_t outlen = 1;
+    for (const wchar_t* c = str; *c; c++) {
+        if ((unsigned long)*c > 0x10FFFF) {
+            *result = NULL;
+            return -1;
+        }
+        outlen += *c < 0x80 ? 1 : *c < 0x800 ? 2 : *c < 0x10000 ? 3 : 4;
+    }
+
+    char* out = *result = (char*)malloc(outlen);
+    for (const wchar_t* c = str; *c; c++) {
+        unsigned long cp = (unsigned long)*c;
+        if (cp < 0x80) {
+            *out++ = (char)cp;
+        } else if (cp < 0x800) {
+            *out++ = (char)(0xC0 | (cp >> 6));
+            *out++ = (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            *out++ = (char)(0xE0 | (cp >> 12));
+            *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (cp & 0x3F));
+        } else {
+            *out++ = (char)(0xF0 | (cp >> 18));
+            *out++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+            *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (cp & 0x3F));
+        }
+    }
+    *out = '\0';
+    return 0;
+}
 #endif
 
+/*
+* Device 0 keeps the plain "keybd-g1-m1" and "mouse-g6-m0" identifiers so existing bindings stay valid,
+* additional devices are numbered from 2 as in "keybd2-g1-m1".
+*/
+static void GkeyBuildIdentifiers() {
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++) {
+        const unsigned int device = GKEY_SLOT_DEVICE(slot);
+        char number[4] = "";
+        if (device)
+            snprintf(number, sizeof(number), "%u", device + 1);
+        snprintf(gkeyIdentifiers[slot], GKEY_ID_BUFSIZE, "%s%s-g%u-m%u",
+            GKEY_SLOT_MOUSE(slot) ? GKEY_MOUSE_ID : GKEY_KEYBOARD_ID, number, (slot >> 2) & 0xFF, slot & 0x3);
+    }
+
+    for (unsigned int device = 0; device < GKEY_DEVICE_COUNT; device++) {
+        for (unsigned int mouse = 0; mouse < 2; mouse++) {
+            char* name = gkeyDeviceNames[device][mouse];
+            const size_t len = snprintf(name, sizeof(gkeyDeviceNames[device][mouse]), "Logitech %s", mouse ? "Mouse" : "Keyboard");
+            if (device)
+                snprintf(name + len, sizeof(gkeyDeviceNames[device][mouse]) - len, " %u", device + 1);
+        }
+    }
+}
+
+/*
+* Parses a "<device>-g<keyIdx>-m<mState>" identifier in place, returns false if it is not one of ours.
+* Only the canonical form built by GkeyBuildIdentifiers is accepted so every key has a single identifier.
+*/
+static bool GkeyParseIdentifier(const char* keyIdentifier, GkeyCode* code) {
+    GkeyCode result = { 0 };
+    if (strncmp(keyIdentifier, GKEY_MOUSE_ID, sizeof(GKEY_MOUSE_ID) - 1) == 0)
+        result.mouse = 1;
+    else if (strncmp(keyIdentifier, GKEY_KEYBOARD_ID, sizeof(GKEY_KEYBOARD_ID) - 1) != 0)
+        return false;
+
+    const char* p = keyIdentifier + sizeof(GKEY_MOUSE_ID) - 1;
+    if (*p >= '2' && *p < '1' + GKEY_DEVICE_COUNT)
+        result.reserved1 = *p++ - '1';
+    if (*p++ != '-' || *p++ != 'g')
+        return false;
+
+    unsigned int keyIdx = 0;
+    const char* digits = p;
+    while (*p >= '0' && *p <= '9' && p - digits < 3)
+        keyIdx = keyIdx * 10 + (*p++ - '0');
+    if (p == digits || keyIdx > 0xFF || (*digits == '0' && p - digits > 1))
+        return false;
+
+    if (*p++ != '-' || *p++ != 'm')
+        return false;
+    if (*p < '0' || *p > '3' || p[1] != '\0')
+        return false;
+
+    result.keyIdx = keyIdx;
+    result.mState = *p - '0';
+    *code = result;
+    return true;
+}
+
+/* Parses the "<key>-tap" and "<key>-hold" identifiers of tap_hold keys into the code of the key */
+static bool GkeyParseTapHold(const char* keyIdentifier, GkeyCode* code) {
+    const char* suffix = strrchr(keyIdentifier, '-');
+    if (!suffix || suffix - keyIdentifier >= GKEY_ID_BUFSIZE)
+        return false;
+    if (strcmp(suffix, GKEY_TAP_SUFFIX) != 0 && strcmp(suffix, GKEY_HOLD_SUFFIX) != 0)
+        return false;
+
+    char key[GKEY_ID_BUFSIZE];
+    memcpy(key, keyIdentifier, suffix - keyIdentifier);
+    key[suffix - keyIdentifier] = '\0';
+    return GkeyParseIdentifier(key, code);
+}
+
+/* Parses a list of key identifiers separated by the given delimiter into key slots */
+static unsigned int GkeyParseKeyList(const char* list, char delimiter, unsigned int* slots, unsigned int maxSlots) {
+    unsigned int count = 0;
+    const char* start = list;
+    for (;;) {
+        const char* end = strchr(start, delimiter);
+        if (!end)
+            end = start + strlen(start);
+
+        /* Trim the identifier and copy it so it can be parsed on its own */
+        while (start < end && *start == ' ')
+            start++;
+        const char* last = end;
+        while (last > start && last[-1] == ' ')
+            last--;
+
+        char keyIdentifier[GKEY_ID_BUFSIZE];
+        GkeyCode code;
+        if (last - start >= GKEY_ID_BUFSIZE || count == maxSlots)
+            return 0;
+        memcpy(keyIdentifier, start, last - start);
+        keyIdentifier[last - start] = '\0';
+        if (!GkeyParseIdentifier(keyIdentifier, &code))
+            return 0;
+        slots[count++] = GKEY_SLOT(code);
+
+        if (*end == '\0')
+            return count;
+        start = end + 1;
+    }
+}
+
+static void GkeyLoadCombos() {
+    ComboClear();
+
+    /* Combos are numbered in the order of the file, an invalid one keeps its number so the others don't shift */
+    unsigned int slots[COMBO_MAX_KEYS];
+    for (size_t i = 0; i < gkeyConfig.combos.size(); i++) {
+        const GkeyComboConfig& combo = gkeyConfig.combos[i];
+        const unsigned int count = GkeyParseKeyList(combo.keys.c_str(), combo.sequence ? ',' : '+', slots, COMBO_MAX_KEYS);
+        if (!ComboAdd((unsigned int)i + 1, combo.sequence, slots, count, combo.keys.c_str()))
+            printf("PLUGIN: Invalid %s: %s\n", combo.sequence ? "sequence" : "chord", combo.keys.c_str());
+    }
+
+    ComboCompile(gkeyConfig.comboTimeout * 1000000ULL);
+}
+
+static void GkeyLoadActions() {
+    memset(gkeyActions, GKEY_ACTION_NONE, sizeof(gkeyActions));
+
+    const struct {
+        const std::vector<std::string>& keys;
+        GkeyAction action;
+    } bindings[] = {
+        { gkeyConfig.pushToTalk, GKEY_ACTION_PUSH_TO_TALK },
+        { gkeyConfig.toggleInput, GKEY_ACTION_TOGGLE_INPUT },
+    };
+    for (const auto& binding : bindings) {
+        for (const std::string& key : binding.keys) {
+            GkeyCode code;
+            if (GkeyParseIdentifier(key.c_str(), &code))
+                gkeyActions[GKEY_SLOT(code)] = (uint8_t)binding.action;
+            else
+                printf("PLUGIN: Invalid key: %s\n", key.c_str());
+        }
+    }
+
+    pushToTalkSlots.clear();
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++) {
+        pushToTalkConnections[slot].store(0, std::memory_order_relaxed);
+        if (gkeyActions[slot] == GKEY_ACTION_PUSH_TO_TALK)
+            pushToTalkSlots.push_back(slot);
+    }
+}
+
+/* Push-to-talk starts out muted, unless one of its keys is still held on the connection */
+static void GkeyDeactivateInput(uint64 serverConnectionHandlerID) {
+    if (!serverConnectionHandlerID || pushToTalkSlots.empty())
+        return;
+    for (unsigned int slot : pushToTalkSlots) {
+        if (pushToTalkConnections[slot].load(std::memory_order_relaxed) == serverConnectionHandlerID)
+            return;
+    }
+    if (ts3Functions.setClientSelfVariableAsInt(serverConnectionHandlerID, CLIENT_INPUT_DEACTIVATED, INPUT_DEACTIVATED) == ERROR_ok)
+        ts3Functions.flushClientSelfUpdates(serverConnectionHandlerID, NULL);
+}
+
+static void GkeyLoadTimers() {
+    memset(gkeyTimerModes, GKEY_TIMER_NONE, sizeof(gkeyTimerModes));
+    gkeyTapHoldIds.clear();
+
+    const struct {
+        const std::vector<std::string>& keys;
+        GkeyTimerMode mode;
+    } bindings[] = {
+        { gkeyConfig.repeatKeys, GKEY_TIMER_REPEAT },
+        { gkeyConfig.tapHold, GKEY_TIMER_TAP_HOLD },
+    };
+    for (const auto& binding : bindings) {
+        for (const std::string& key : binding.keys) {
+            GkeyCode code;
+            if (!GkeyParseIdentifier(key.c_str(), &code)) {
+                printf("PLUGIN: Invalid key: %s\n", key.c_str());
+                continue;
+            }
+
+            const unsigned int slot = GKEY_SLOT(code);
+            if (binding.mode == GKEY_TIMER_TAP_HOLD && gkeyTimerModes[slot] != GKEY_TIMER_TAP_HOLD) {
+                GkeyTapHoldIds ids;
+                snprintf(ids.tap, sizeof(ids.tap), "%s%s", gkeyIdentifiers[slot], GKEY_TAP_SUFFIX);
+                snprintf(ids.hold, sizeof(ids.hold), "%s%s", gkeyIdentifiers[slot], GKEY_HOLD_SUFFIX);
+                gkeyTapHoldIndex[slot] = (uint16_t)gkeyTapHoldIds.size();
+                gkeyTapHoldIds.push_back(ids);
+            }
+            gkeyTimerModes[slot] = (uint8_t)binding.mode;
+        }
+    }
+}
+
+/* Asks the SDK for the friendly name of a key, returns NULL if it has none */
+static char* GkeyFetchDisplayName(GkeyCode code) {
+    if (GKEY_DEVICE(code))
+        return NULL;  /* The SDK only knows the names of device 0 */
+
+    const uint64_t start = StatsEnabled() ? GkeyTimestamp() : 0;
+    wchar_t* text = NULL;
+    if (code.mouse)
+        text = LogiGkeyGetMouseButtonString(code.keyIdx);
+    else
+        text = LogiGkeyGetKeyboardGkeyString(code.keyIdx, code.mState);
+    if (start)
+        StatsRecordTime(STATS_SDK_FETCH, GkeyTimestamp() - start);
+
+    /* TeamSpeak expects UTF-8 encoded characters */
+    char* result = NULL;
+    if (!text || wcharToUtf8(text, &result) == -1)
+        return NULL;
+    return result;
+}
+
+/* Drops all cached display names so they are fetched again, e.g. after the SDK reconnected to a different profile */
+static void GkeyInvalidateDisplayNames() {
+    std::lock_guard<std::mutex> lock(gkeyRetiredNamesMutex);
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++) {
+        char* name = gkeyDisplayNames[slot].exchange(NULL, std::memory_order_acq_rel);
+        if (name && name != gkeyIdentifiers[slot])
+            gkeyRetiredNames.push_back(name);
+        for (unsigned int half = 0; half < 2; half++) {
+            name = gkeyTapHoldNames[half][slot].exchange(NULL, std::memory_order_acq_rel);
+            if (name)
+                gkeyRetiredNames.push_back(name);
+        }
+    }
+}
+
+/* Releases all display names, only safe once the client can no longer hold on to them */
+static void GkeyFreeDisplayNames() {
+    GkeyInvalidateDisplayNames();
+
+    std::lock_guard<std::mutex> lock(gkeyRetiredNamesMutex);
+    for (char* name : gkeyRetiredNames)
+        free(name);
+    gkeyRetiredNames.clear();
+}
+
+static const char* GkeySlotName(unsigned int slot) {
+    return gkeyIdentifiers[slot];
+}
+
+/* Timeline keys are slots, followed by the combos */
+static const char* GkeyTimelineKeyName(uint32_t key) {
+    if (key < GKEY_SLOT_COUNT)
+        return gkeyIdentifiers[key];
+    if (key - GKEY_SLOT_COUNT < ComboCount())
+        return ComboIdentifier(key - GKEY_SLOT_COUNT);
+    return NULL;
+}
+
+static void GkeyWriteTimeline(const char* path, StatsPrintFunc print) {
+    /* The path can come from the command line, so cut it off instead of overflowing sprintf_s on Windows */
+    char line[PATH_BUFSIZE + 64];
+    const long spans = TimelineWrite(path, GkeyTimelineKeyName);
+    if (spans < 0)
+        snprintf(line, sizeof(line), "Failed to write the timeline to %.*s", PATH_BUFSIZE, path);
+    else
+        snprintf(line, sizeof(line), "Timeline: wrote %ld spans to %.*s", spans, PATH_BUFSIZE, path);
+    print(line);
+}
+
+static void GkeyLogLine(const char* line) {
+    ts3Functions.logMessage(line, LogLevel_DEBUG, ts3plugin_name(), 0);
+}
+
+static void GkeyPrintStats(StatsPrintFunc print) {
+    char line[256];
+    if (SdkReadyLatency()) {
+        snprintf(line, sizeof(line), "Startup: init took %lluus, SDK ready after %llums and %u attempts",
+            (unsigned long long)(initDuration / 1000), (unsigned long long)(SdkReadyLatency() / 1000000), SdkAttempts());
+    } else {
+        snprintf(line, sizeof(line), "Startup: init took %lluus, SDK not ready after %u attempts",
+            (unsigned long long)(initDuration / 1000), SdkAttempts());
+    }
+    print(line);
+
+    snprintf(line, sizeof(line), "Display name cache: %llu hits, %llu misses, %llu fallbacks",
+        displayNameHits.load(), displayNameMisses.load(), displayNameFallbacks.load());
+    print(line);
+
+    DispatcherStats dispatcher;
+    DispatcherGetStats(&dispatcher);
+    snprintf(line, sizeof(line), "Dispatcher: %llu enqueued, %llu dispatched, %llu dropped, %llu deferred key-ups, "
+        "%llu orphan key-ups, max depth %u, avg latency %lluns, max latency %lluns",
+        dispatcher.enqueued, dispatcher.dispatched, dispatcher.dropped, dispatcher.deferredUps, dispatcher.orphanUps,
+        (unsigned int)dispatcher.maxDepth,
+        dispatcher.dispatched ? (unsigned long long)(dispatcher.totalLatency / dispatcher.dispatched) : 0ULL,
+        (unsigned long long)dispatcher.maxLatency);
+    print(line);
+
+    DebounceStats debounce;
+    DebounceGetStats(&debounce);
+    snprintf(line, sizeof(line), "Debounce: %llu duplicate edges and %llu chatter edges suppressed, %llu settled",
+        debounce.duplicates, debounce.chatter, debounce.settled);
+    print(line);
+
+    if (gkeyConfig.backend == GKEY_BACKEND_POLL) {
+        PollerStats poller;
+        PollerGetStats(&poller);
+        snprintf(line, sizeof(line), "Polling: %llu wakeups, %llu edges, %lluus spent polling, worst-case detection latency %lluus",
+            poller.wakeups, poller.edges, (unsigned long long)(poller.pollTime / 1000), (unsigned long long)(poller.maxDetectLatency / 1000));
+        print(line);
+    }
+
+    if (gkeyConfig.backend == GKEY_BACKEND_EVDEV) {
+        EvdevStats evdev;
+        EvdevGetStats(&evdev);
+        snprintf(line, sizeof(line), "Evdev: %llu reads, %llu events (%llu per read), %llu key edges, avg latency %lluns, max latency %lluns",
+            evdev.reads, evdev.events, evdev.reads ? evdev.events / evdev.reads : 0ULL, evdev.keyEvents,
+            evdev.latencySamples ? (unsigned long long)(evdev.totalLatency / evdev.latencySamples) : 0ULL,
+            (unsigned long long)evdev.maxLatency);
+        print(line);
+    }
+
+    if (!gkeyConfig.repeatKeys.empty() || !gkeyConfig.tapHold.empty()) {
+        TimerWheelStats timers;
+        TimerWheelGetStats(&timers);
+        snprintf(line, sizeof(line), "Timers: %llu fired, avg jitter %lluus, max jitter %lluus, %lluns per expiry, at most %u pending",
+            timers.fired, (unsigned long long)(timers.fired ? timers.totalJitter / timers.fired / 1000 : 0),
+            (unsigned long long)(timers.maxJitter / 1000), (unsigned long long)(timers.fired ? timers.advanceTime / timers.fired : 0),
+            timers.maxActive);
+        print(line);
+    }
+
+    if (ComboCount()) {
+        snprintf(line, sizeof(line), "Combos: %u defined, %llu matched", ComboCount(), ComboMatches());
+        print(line);
+    }
+
+    StatsPrint(print, GkeySlotName);
+}
+
 /*********************************** Required functions ************************************/
 /*
 * If any of these required functions is not implemented, TS3 will refuse to load the plugin
@@ -86,15 +530,187 @@ void ts3plugin_setFunctionPointers(const struct TS3Functions funcs) {
     ts3Functions = funcs;
 }
 
-void __cdecl GkeySDKCallback(GkeyCode gkeyCode, wchar_t* gkeyOrButtonString, void* context)
-{
-    // Construct our own consistent identifier
-    char keyId[GKEY_ID_BUFSIZE];
-    snprintf(keyId, GKEY_ID_BUFSIZE, "%s-g%d-m%d", gkeyCode.mouse ? "mouse" : "keybd", gkeyCode.keyIdx, gkeyCode.mState);
+static void GkeyNotify(const char* keyIdentifier, uint32_t timelineKey, bool down) {
+    const uint64_t start = StatsEnabled() || TimelineEnabled() ? GkeyTimestamp() : 0;
 
     // Notify Teamspeak of the G-Key event
     // For the up_down parameter 1 = up and 0 = down, so invert it
-    ts3Functions.notifyKeyEvent(pluginID, keyId, !gkeyCode.keyDown);
+    ts3Functions.notifyKeyEvent(pluginID, keyIdentifier, !down);
+
+    if (start) {
+        const uint64_t end = GkeyTimestamp();
+        if (StatsEnabled())
+            StatsRecordTime(STATS_NOTIFY, end - start);
+        if (TimelineEnabled())
+            TimelineRecord(TIMELINE_NOTIFY, start, end, timelineKey);
+    }
+}
+
+static void GkeyNotifyCombo(unsigned int combo, bool down, uint64_t timestamp) {
+    GkeyNotify(ComboIdentifier(combo), GKEY_SLOT_COUNT + combo, down);
+}
+
+/* Activates or deactivates the microphone on the current server connection, push-to-talk is released where it was pressed */
+static void GkeyRunAction(GkeyAction action, unsigned int slot, bool down) {
+    uint64 serverConnectionHandlerID = currentServerConnection.load(std::memory_order_relaxed);
+    if (action == GKEY_ACTION_PUSH_TO_TALK && !down)
+        serverConnectionHandlerID = pushToTalkConnections[slot].exchange(0, std::memory_order_relaxed);
+    if (!serverConnectionHandlerID)
+        return;
+
+    int deactivated;
+    if (action == GKEY_ACTION_PUSH_TO_TALK) {
+        if (down)
+            pushToTalkConnections[slot].store(serverConnectionHandlerID, std::memory_order_relaxed);
+        deactivated = down ? INPUT_ACTIVE : INPUT_DEACTIVATED;
+    } else if (down) {
+        if (ts3Functions.getClientSelfVariableAsInt(serverConnectionHandlerID, CLIENT_INPUT_DEACTIVATED, &deactivated) != ERROR_ok)
+            return;
+        deactivated = deactivated == INPUT_ACTIVE ? INPUT_DEACTIVATED : INPUT_ACTIVE;
+    } else {
+        return;  /* Toggling only happens on the key-down */
+    }
+
+    const uint64_t start = StatsEnabled() || TimelineEnabled() ? GkeyTimestamp() : 0;
+    if (ts3Functions.setClientSelfVariableAsInt(serverConnectionHandlerID, CLIENT_INPUT_DEACTIVATED, deactivated) == ERROR_ok)
+        ts3Functions.flushClientSelfUpdates(serverConnectionHandlerID, NULL);
+    if (start) {
+        const uint64_t end = GkeyTimestamp();
+        if (StatsEnabled())
+            StatsRecordTime(STATS_DIRECT_ACTION, end - start);
+        if (TimelineEnabled())
+            TimelineRecord(TIMELINE_DIRECT_ACTION, start, end, slot);
+    }
+}
+
+/* Repeat keys are notified right away and then again on a timer, tap_hold keys wait for the hold time to pass */
+static void GkeyTimedKey(unsigned int slot, bool down, uint64_t timestamp) {
+    if (gkeyTimerModes[slot] == GKEY_TIMER_REPEAT) {
+        if (down)
+            TimerWheelSchedule(slot, timestamp, timestamp + gkeyConfig.repeatDelay * 1000000ULL);
+        else
+            TimerWheelCancel(slot);
+        GkeyNotify(gkeyIdentifiers[slot], slot, down);
+        return;
+    }
+
+    const GkeyTapHoldIds& ids = gkeyTapHoldIds[gkeyTapHoldIndex[slot]];
+    if (down) {
+        TimerWheelSchedule(slot, timestamp, timestamp + gkeyConfig.holdTime * 1000000ULL);
+    } else if (TimerWheelPending(slot)) {
+        /* Released before the hold time passed, so it was a tap */
+        TimerWheelCancel(slot);
+        GkeyNotify(ids.tap, slot, true);
+        GkeyNotify(ids.tap, slot, false);
+    } else {
+        GkeyNotify(ids.hold, slot, false);
+    }
+}
+
+/* Runs on the dispatcher thread when a repeat key is due to be pressed again or a tap_hold key has been held long enough */
+static void GkeyTimerExpired(unsigned int slot, uint64_t deadline) {
+    if (gkeyTimerModes[slot] == GKEY_TIMER_REPEAT) {
+        GkeyNotify(gkeyIdentifiers[slot], slot, false);
+        GkeyNotify(gkeyIdentifiers[slot], slot, true);
+        TimerWheelSchedule(slot, deadline, deadline + gkeyConfig.repeatInterval * 1000000ULL);
+    } else {
+        GkeyNotify(gkeyTapHoldIds[gkeyTapHoldIndex[slot]].hold, slot, true);
+    }
+}
+
+/* Delivers a key edge that passed debouncing, both as the key itself and to any combos it is part of */
+static void GkeyDeliver(GkeyCode code, uint64_t timestamp) {
+    const uint64_t start = TimelineEnabled() ? GkeyTimestamp() : 0;
+    const unsigned int slot = GKEY_SLOT(code);
+    const GkeyAction action = (GkeyAction)gkeyActions[slot];
+    // Use our own consistent identifier for the key
+    const char* keyIdentifier = gkeyIdentifiers[slot];
+    if (start)
+        TimelineRecord(TIMELINE_IDENTIFIER, start, GkeyTimestamp(), slot);
+
+    if (action != GKEY_ACTION_NONE)
+        GkeyRunAction(action, slot, code.keyDown != 0);
+    else if (gkeyTimerModes[slot] != GKEY_TIMER_NONE)
+        GkeyTimedKey(slot, code.keyDown != 0, timestamp);
+    else
+        GkeyNotify(keyIdentifier, slot, code.keyDown != 0);
+    ComboProcess(code, timestamp, GkeyNotifyCombo);
+}
+
+/* Runs on the dispatcher thread, or on the SDK thread if the queue is disabled */
+static void GkeyDispatch(GkeyCode code, uint64_t timestamp) {
+    if (TimelineEnabled())
+        TimelineRecord(TIMELINE_QUEUED, timestamp, GkeyTimestamp(), GKEY_SLOT(code));
+    if (DebounceFilter(code, timestamp))
+        GkeyDeliver(code, timestamp);
+}
+
+/* Runs on the dispatcher thread to deliver events that are due at a later time */
+static uint64_t GkeyTick(uint64_t now) {
+    const uint64_t settle = DebounceSettle(now, GkeyDeliver);
+    const uint64_t timer = TimerWheelAdvance(now, GkeyTimerExpired);
+    return settle && (!timer || settle < timer) ? settle : timer;
+}
+
+/* Entry point for key events from the SDK, the poller, event devices or a replayed trace, only one of which runs */
+static void GkeyInput(GkeyCode code) {
+    const uint64_t start = TimelineEnabled() ? GkeyTimestamp() : 0;
+    if (StatsEnabled())
+        StatsCountEvent(code);
+    RecorderRecord(code);
+
+    // Hand the event off to the dispatcher so the input thread is never blocked by the client
+    DispatcherEnqueue(code);
+
+    if (start)
+        TimelineRecord(TIMELINE_INPUT, start, GkeyTimestamp(), GKEY_SLOT(code));
+}
+
+/* The SDK calls back on a single thread of its own, never from several threads at once */
+void __cdecl GkeySDKCallback(GkeyCode gkeyCode, wchar_t* gkeyOrButtonString, void* context)
+{
+    if (!sdkCallbackGate.enter())
+        return;
+    gkeyCode.reserved1 = 0;  /* Events from the SDK are always on device 0 */
+    GkeyInput(gkeyCode);
+    sdkCallbackGate.leave();
+}
+
+static bool GkeyStartEvdev() {
+    EvdevResetMap();
+    for (const std::string& mapping : gkeyConfig.evdevMap) {
+        char* end;
+        const unsigned long keyCode = strtoul(mapping.c_str(), &end, 10);
+        while (*end == ' ')
+            end++;
+
+        GkeyCode code;
+        if (end == mapping.c_str() || !GkeyParseIdentifier(end, &code) || !EvdevMapKey(keyCode, GKEY_SLOT(code)))
+            printf("PLUGIN: Invalid evdev mapping: %s\n", mapping.c_str());
+    }
+
+    /* Devices are given as "<path> [device number]", the number matches the one in identifiers like "keybd2-g1-m1" */
+    std::vector<std::string> paths;
+    std::vector<unsigned int> devices;
+    for (const std::string& device : gkeyConfig.evdevDevices) {
+        const size_t space = device.find_last_of(' ');
+        unsigned int number = 1;
+        if (space != std::string::npos) {
+            char* end;
+            number = (unsigned int)strtoul(device.c_str() + space + 1, &end, 10);
+            if (*end != '\0' || number < 1 || number > GKEY_DEVICE_COUNT) {
+                printf("PLUGIN: Invalid evdev device: %s\n", device.c_str());
+                continue;
+            }
+        }
+        paths.push_back(space != std::string::npos ? device.substr(0, device.find_last_not_of(' ', space) + 1) : device);
+        devices.push_back(number - 1);
+    }
+
+    std::vector<const char*> pathNames;
+    for (const std::string& path : paths)
+        pathNames.push_back(path.c_str());
+    return EvdevStart(pathNames.data(), devices.data(), (unsigned int)pathNames.size(), GkeyInput);
 }
 
 /*
@@ -102,12 +718,36 @@ void __cdecl GkeySDKCallback(GkeyCode gkeyCode, wchar_t* gkeyOrButtonString, voi
 * If the function returns 1 on failure, the plugin will be unloaded again.
 */
 int ts3plugin_init() {
-    logiGkeyCBContext gkeyContext;
-    ZeroMemory(&gkeyContext, sizeof(gkeyContext));
-    gkeyContext.gkeyCallBack = (logiGkeyCB)GkeySDKCallback;
-    gkeyContext.gkeyContext = NULL;
+    const uint64_t initStart = GkeyTimestamp();
+
+    char configPath[PATH_BUFSIZE];
+    ts3Functions.getConfigPath(configPath, PATH_BUFSIZE);
+    size_t len = strlen(configPath);
+    snprintf(configPath + len, PATH_BUFSIZE - len, "%s", GKEY_CONFIG_FILE);
+    ConfigLoad(configPath);
+    statsEnabled.store(gkeyConfig.stats);
+    snprintf(configPath + len, PATH_BUFSIZE - len, "%s", GKEY_TIMELINE_FILE);
+    _strcpy(timelinePath, PATH_BUFSIZE, configPath);
+    if (gkeyConfig.timeline)
+        TimelineStart(gkeyConfig.timelineSpans);
 
-    LogiGkeyInit(&gkeyContext);
+    GkeyBuildIdentifiers();
+    GkeyLoadCombos();
+    GkeyLoadActions();
+    GkeyLoadTimers();
+    currentServerConnection.store(ts3Functions.getCurrentServerConnectionHandlerID());
+    GkeyDeactivateInput(currentServerConnection.load());
+    DebounceInit(gkeyConfig.debounceKeyboard * 1000000ULL, gkeyConfig.debounceMouse * 1000000ULL);
+    TimerWheelInit(GkeyTimestamp());
+    if (!DispatcherStart(gkeyConfig.queueCapacity, gkeyConfig.dispatcherHighPriority, GkeyDispatch, GkeyTick)) {
+        /* Without the dispatcher thread nothing settles a debounced key or fires a timer, so only suppress duplicates */
+        DebounceInit(0, 0);
+        memset(gkeyTimerModes, GKEY_TIMER_NONE, sizeof(gkeyTimerModes));
+    }
+    if (*gkeyConfig.recordFile)
+        RecorderStart(gkeyConfig.recordFile);
+
+    initDuration = GkeyTimestamp() - initStart;
 
     return 0;  /* 0 = success, 1 = failure, -2 = failure but client will not show a "failed to load" warning */
                /* -2 is a very special case and should only be used if a plugin displays a dialog (e.g. overlay) asking the user to disable
@@ -115,9 +755,55 @@ int ts3plugin_init() {
                * For normal case, if a plugin really failed to load because of an error, the correct return value is 1. */
 }
 
+/*
+* Starts the source of key events. Exactly one runs and each delivers all of its events from a single thread,
+* which is the only producer the dispatcher queue and the recorder allow.
+*/
+static void GkeyStartInput() {
+    /* A replayed trace takes the place of the SDK as the source of key events */
+    if (*gkeyConfig.replayFile) {
+        ReplayStart(gkeyConfig.replayFile, gkeyConfig.replayRealtime, GkeyInput);
+    } else if (gkeyConfig.backend == GKEY_BACKEND_EVDEV) {
+        if (!GkeyStartEvdev())
+            printf("PLUGIN: No event devices could be opened\n");
+    } else if (gkeyConfig.backend == GKEY_BACKEND_POLL) {
+        /* Without a callback the SDK only tracks the pressed state for the poller */
+        SdkStart(NULL, GkeyInvalidateDisplayNames);
+        PollerStart(gkeyConfig.pollInterval, gkeyConfig.pollIdleInterval, GkeyInput);
+    } else {
+        logiGkeyCBContext gkeyContext;
+        memset(&gkeyContext, 0, sizeof(gkeyContext));
+        gkeyContext.gkeyCallBack = (logiGkeyCB)GkeySDKCallback;
+        gkeyContext.gkeyContext = NULL;
+
+        /* Names looked up before the SDK was ready are only fallbacks, fetch them again */
+        SdkStart(&gkeyContext, GkeyInvalidateDisplayNames);
+    }
+}
+
 /* Custom code called right before the plugin is unloaded */
 void ts3plugin_shutdown() {
-    LogiGkeyShutdown();
+    /*
+    * The SDK gives no guarantee that its callback has returned once it is shut down, so turn away new
+    * callbacks and wait for the running ones first. After this only our own threads use the plugin state.
+    */
+    sdkCallbackGate.close();
+
+    if (*gkeyConfig.replayFile) {
+        ReplayStop();
+    } else {
+        EvdevStop();
+        PollerStop();
+        SdkStop();
+    }
+    RecorderStop();
+    DispatcherStop();
+
+    GkeyPrintStats(GkeyLogLine);
+    if (TimelineEnabled())
+        GkeyWriteTimeline(timelinePath, GkeyLogLine);
+    TimelineStop();
+    GkeyFreeDisplayNames();
 
     /*
     * Note:
@@ -162,20 +848,55 @@ void ts3plugin_registerPluginID(const char* id) {
     const size_t sz = strlen(id) + 1;
     pluginID = (char*)malloc(sz * sizeof(char));
     _strcpy(pluginID, sz, id);  /* The id buffer will invalidate after exiting this function */
+
+    /* The client registers the ID after ts3plugin_init, no key event can be notified before that */
+    sdkCallbackGate.open();
+    GkeyStartInput();
 }
 
 /* Plugin command keyword. Return NULL or "" if not used. */
 const char* ts3plugin_commandKeyword() {
-    return NULL;
+    return GKEY_COMMAND_KEYWORD;
 }
 
 /* Plugin processes console command. Return 0 if plugin handled the command, 1 if not handled. */
 int ts3plugin_processCommand(uint64 serverConnectionHandlerID, const char* command) {
+    if (strcmp(command, "stats") == 0) {
+        if (!StatsEnabled())
+            ts3Functions.printMessageToCurrentTab("Per-key statistics are disabled, set stats = true in " GKEY_CONFIG_FILE " to enable them");
+        GkeyPrintStats(ts3Functions.printMessageToCurrentTab);
+    } else if (strcmp(command, "reset") == 0) {
+        displayNameHits.store(0);
+        displayNameMisses.store(0);
+        displayNameFallbacks.store(0);
+        DispatcherResetStats();
+        DebounceResetStats();
+        TimerWheelResetStats();
+        PollerResetStats();
+        EvdevResetStats();
+        StatsReset();
+        TimelineClear();
+        ts3Functions.printMessageToCurrentTab("G-Key statistics reset");
+    } else if (strncmp(command, "timeline", 8) == 0 && (command[8] == '\0' || command[8] == ' ')) {
+        if (!TimelineEnabled()) {
+            ts3Functions.printMessageToCurrentTab("The timeline is disabled, set timeline = true in " GKEY_CONFIG_FILE " to enable it");
+            return 0;
+        }
+        const char* path = command + 8;
+        while (*path == ' ')
+            path++;
+        GkeyWriteTimeline(*path ? path : timelinePath, ts3Functions.printMessageToCurrentTab);
+    } else {
+        ts3Functions.printMessageToCurrentTab("Usage: /" GKEY_COMMAND_KEYWORD " <stats|reset|timeline [file]>");
+        return 1;  /* Plugin did not handle command */
+    }
     return 0;  /* Plugin handled command */
 }
 
 /* Client changed current server connection handler */
 void ts3plugin_currentServerConnectionChanged(uint64 serverConnectionHandlerID) {
+    currentServerConnection.store(serverConnectionHandlerID, std::memory_order_relaxed);
+    GkeyDeactivateInput(serverConnectionHandlerID);
 }
 
 /*
@@ -198,55 +919,109 @@ int ts3plugin_requestAutoload() {
 // This function receives your key Identifier you send to notifyKeyEvent and should return
 // the friendly device name of the device this hotkey originates from. Used for display in UI.
 const char* ts3plugin_keyDeviceName(const char* keyIdentifier) {
-    if (strstr(keyIdentifier, GKEY_MOUSE_ID))
-        return "Logitech Mouse";
-    else
-        return "Logitech Keyboard";
+    GkeyCode code = { 0 };
+    unsigned int combo;
+    if (!GkeyParseIdentifier(keyIdentifier, &code) && !GkeyParseTapHold(keyIdentifier, &code) && ComboParseIdentifier(keyIdentifier, &combo))
+        return gkeyComboDeviceName;
+    return gkeyDeviceNames[GKEY_DEVICE(code)][code.mouse];
 }
 
-GkeyCode GkeyIdentifierToCode(const char* keyIdentifier) {
-    // Allocate a string we can modify
-    size_t len = strlen(keyIdentifier) + 1;
-    char* str = (char*)malloc(len);
-    _strcpy(str, len, keyIdentifier);
+/* Display name of a key, fetched from the SDK on the first lookup and cached until it is invalidated */
+static const char* GkeyLookupKeyName(GkeyCode code) {
+    const unsigned int slot = GKEY_SLOT(code);
+    char* name = gkeyDisplayNames[slot].load(std::memory_order_acquire);
+    if (name) {
+        displayNameHits.fetch_add(1, std::memory_order_relaxed);
+        return name;
+    }
+    displayNameMisses.fetch_add(1, std::memory_order_relaxed);
 
-    // Tokenize the string
-    char* cntx = str;
-    char* device = _strtok(cntx, "-");
-    char* gkey = _strtok(cntx, "-");
-    char* mkey = _strtok(cntx, "-");
+    /* Don't wait for the SDK, but also don't cache anything until it is ready */
+    if (!SdkReady()) {
+        displayNameFallbacks.fetch_add(1, std::memory_order_relaxed);
+        return gkeyIdentifiers[slot];
+    }
 
-    // Construct the gkey code
-    GkeyCode code = { 0 };
-    if (device)
-        code.mouse = (strcmp(device, GKEY_MOUSE_ID) == 0) ? 1 : 0;
-    if (gkey)
-        code.keyIdx = atoi(gkey + 1);
-    if (mkey)
-        code.mState = atoi(mkey + 1);
+    /* Fall back to our own identifier if the SDK has no name for this key */
+    char* fetched = GkeyFetchDisplayName(code);
+    if (!fetched) {
+        displayNameFallbacks.fetch_add(1, std::memory_order_relaxed);
+        fetched = gkeyIdentifiers[slot];
+    }
+
+    /* Another thread may have filled the slot in the meantime, in that case use its name */
+    if (!gkeyDisplayNames[slot].compare_exchange_strong(name, fetched, std::memory_order_acq_rel)) {
+        if (fetched != gkeyIdentifiers[slot])
+            free(fetched);
+        return name;
+    }
+    return fetched;
+}
+
+/* Names the tap and hold halves of a tap_hold key after the key's own display name */
+static const char* GkeyLookupTapHoldName(const char* keyIdentifier, GkeyCode code) {
+    const unsigned int slot = GKEY_SLOT(code);
+    const char* suffix = strrchr(keyIdentifier, '-');
+    std::atomic<char*>& cached = gkeyTapHoldNames[strcmp(suffix, GKEY_HOLD_SUFFIX) == 0][slot];
+    char* name = cached.load(std::memory_order_acquire);
+    if (name) {
+        displayNameHits.fetch_add(1, std::memory_order_relaxed);
+        return name;
+    }
 
-    // Cleanup and return
-    free(str);
-    return code;
+    /* Without a name for the key its identifier already is the best name for either half */
+    const char* keyName = GkeyLookupKeyName(code);
+    if (keyName == gkeyIdentifiers[slot])
+        return keyIdentifier;
+
+    const size_t length = strlen(keyName);
+    char* built = (char*)malloc(length + strlen(suffix) + 1);
+    if (!built)
+        return keyIdentifier;
+    memcpy(built, keyName, length);
+    strcpy(built + length, suffix);
+
+    if (!cached.compare_exchange_strong(name, built, std::memory_order_acq_rel)) {
+        free(built);
+        return name;
+    }
+    return built;
+}
+
+static const char* GkeyLookupDisplayName(const char* keyIdentifier) {
+    GkeyCode code;
+    if (GkeyParseIdentifier(keyIdentifier, &code))
+        return GkeyLookupKeyName(code);
+    if (GkeyParseTapHold(keyIdentifier, &code))
+        return GkeyLookupTapHoldName(keyIdentifier, code);
+
+    unsigned int combo;
+    if (ComboParseIdentifier(keyIdentifier, &combo))
+        return ComboText(combo);
+    return keyIdentifier;
 }
 
 // This function translates the given key identifier to a friendly key name for display in the UI
 const char* ts3plugin_displayKeyText(const char* keyIdentifier) {
-    GkeyCode code = GkeyIdentifierToCode(keyIdentifier);
+    if (!StatsEnabled() && !TimelineEnabled())
+        return GkeyLookupDisplayName(keyIdentifier);
 
-    wchar_t* text = NULL;
-    if (code.mouse)
-        text = LogiGkeyGetMouseButtonString(code.keyIdx);
-    else
-        text = LogiGkeyGetKeyboardGkeyString(code.keyIdx, code.mState);
-
-    /* TeamSpeak expects UTF-8 encoded characters. Following demonstrates a possibility how to convert UTF-16 wchar_t into UTF-8. */
-    static char* result = NULL;  /* Static variable so it's allocated only once */
-    if (result)
-        free(result);
-    if (wcharToUtf8(text, &result) == -1) /* Convert name into UTF-8 encoded result */
-        return keyIdentifier;  /* Conversion failed, fallback here */
-    return result;
+    const uint64_t start = GkeyTimestamp();
+    const char* name = GkeyLookupDisplayName(keyIdentifier);
+    const uint64_t end = GkeyTimestamp();
+    if (StatsEnabled())
+        StatsRecordTime(STATS_DISPLAY_NAME, end - start);
+    if (TimelineEnabled()) {
+        GkeyCode code;
+        unsigned int combo;
+        uint32_t key = TIMELINE_NO_KEY;
+        if (GkeyParseIdentifier(keyIdentifier, &code) || GkeyParseTapHold(keyIdentifier, &code))
+            key = GKEY_SLOT(code);
+        else if (ComboParseIdentifier(keyIdentifier, &combo))
+            key = GKEY_SLOT_COUNT + combo;
+        TimelineRecord(TIMELINE_DISPLAY_NAME, start, end, key);
+    }
+    return name;
 }
 
 // This is used internally as a prefix for hotkeys so we can store them without collisions.
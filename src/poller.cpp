@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include "poller.h"
+#include "sdk_loader.h"
+
+/* The SDK only reports device 0, so only its slots are polled */
+#define POLL_SLOT_WORDS (GKEY_DEVICE_SLOTS / 64)
+
+static std::thread pollerThread;
+static std::mutex pollerMutex;
+static std::condition_variable pollerCond;
+static bool pollerStopping = false;
+static bool polling = false;
+
+static std::atomic<unsigned long long> wakeupCount(0), edgeCount(0);
+static std::atomic<uint64_t> pollTime(0), maxDetectLatency(0);
+
+/* Queries the SDK for every key, returns whether any key is held */
+static bool PollKeys(uint64_t* pressed) {
+    memset(pressed, 0, POLL_SLOT_WORDS * sizeof(uint64_t));
+    bool held = false;
+
+    GkeyCode code = { 0 };
+    for (int gkey = 1; gkey <= LOGITECH_MAX_GKEYS; gkey++) {
+        for (int mode = 1; mode <= LOGITECH_MAX_M_STATES; mode++) {
+            if (LogiGkeyIsKeyboardGkeyPressed(gkey, mode)) {
+                code.keyIdx = gkey;
+                code.mState = mode;
+                pressed[GKEY_SLOT(code) / 64] |= 1ULL << (GKEY_SLOT(code) % 64);
+                held = true;
+            }
+        }
+    }
+
+    /* Mouse buttons have no M-state */
+    code.mouse = 1;
+    code.mState = 0;
+    for (int button = 1; button <= LOGITECH_MAX_MOUSE_BUTTONS; button++) {
+        if (LogiGkeyIsMouseButtonPressed(button)) {
+            code.keyIdx = button;
+            pressed[GKEY_SLOT(code) / 64] |= 1ULL << (GKEY_SLOT(code) % 64);
+            held = true;
+        }
+    }
+    return held;
+}
+
+static void PollerRun(unsigned int activeInterval, unsigned int idleInterval, PollInputFunc input) {
+    uint64_t previous[POLL_SLOT_WORDS] = { 0 };
+    uint64_t pressed[POLL_SLOT_WORDS];
+    unsigned int interval = idleInterval;
+    uint64_t previousStart = 0;  /* An edge happened after the previous poll started, 0 before the first one */
+
+    std::unique_lock<std::mutex> lock(pollerMutex);
+    while (!pollerCond.wait_for(lock, std::chrono::milliseconds(interval), [] { return pollerStopping; })) {
+        lock.unlock();
+        wakeupCount.fetch_add(1, std::memory_order_relaxed);
+
+        bool held = false;
+        if (SdkReady()) {
+            const uint64_t start = GkeyTimestamp();
+            held = PollKeys(pressed);
+            const uint64_t end = GkeyTimestamp();
+            pollTime.fetch_add(end - start, std::memory_order_relaxed);
+
+            for (unsigned int word = 0; word < POLL_SLOT_WORDS; word++) {
+                for (uint64_t changed = pressed[word] ^ previous[word]; changed; changed &= changed - 1) {
+                    unsigned int bit = 0;
+                    while (!((changed >> bit) & 1))
+                        bit++;
+                    /* The actual time between the polls, oversleeping the interval delays detection as well */
+                    if (previousStart)
+                        AtomicMax(maxDetectLatency, end - previousStart);
+
+                    edgeCount.fetch_add(1, std::memory_order_relaxed);
+                    input(GkeyCodeFromSlot(word * 64 + bit, (pressed[word] >> bit) & 1));
+                }
+                previous[word] = pressed[word];
+            }
+            previousStart = start;
+        }
+
+        /* Poll quickly while keys are held, then back off until the thread barely wakes up */
+        if (held)
+            interval = activeInterval;
+        else if (interval < idleInterval)
+            interval = interval * 2 < idleInterval ? interval * 2 : idleInterval;
+
+        lock.lock();
+    }
+}
+
+bool PollerStart(unsigned int activeInterval, unsigned int idleInterval, PollInputFunc input) {
+    if (polling)
+        return false;
+    if (activeInterval == 0)
+        activeInterval = 1;
+    if (idleInterval < activeInterval)
+        idleInterval = activeInterval;
+
+    pollerStopping = false;
+    try {
+        pollerThread = std::thread(PollerRun, activeInterval, idleInterval, input);
+    }
+    catch (const std::system_error&) {
+        printf("PLUGIN: Failed to start the polling thread\n");
+        return false;
+    }
+    polling = true;
+    return true;
+}
+
+void PollerStop() {
+    if (!polling)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(pollerMutex);
+        pollerStopping = true;
+    }
+    pollerCond.notify_all();
+    pollerThread.join();
+    polling = false;
+}
+
+void PollerGetStats(PollerStats* stats) {
+    stats->wakeups = wakeupCount.load();
+    stats->edges = edgeCount.load();
+    stats->pollTime = pollTime.load();
+    stats->maxDetectLatency = maxDetectLatency.load();
+}
+
+void PollerResetStats() {
+    wakeupCount.store(0);
+    edgeCount.store(0);
+    pollTime.store(0);
+    maxDetectLatency.store(0);
+}
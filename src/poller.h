@@ -0,0 +1,27 @@
+#ifndef POLLER_H
+#define POLLER_H
+
+#include <stdint.h>
+#include "gkey.h"
+
+struct PollerStats {
+    unsigned long long wakeups;
+    unsigned long long edges;
+    uint64_t pollTime;          /* Total time spent querying the SDK in nanoseconds */
+    uint64_t maxDetectLatency;  /* Longest time from the previous poll to the one that detected an edge, bounds its latency */
+};
+
+typedef void (*PollInputFunc)(GkeyCode code);
+
+/*
+* Starts polling the pressed state of every G-key and mouse button once the SDK is ready. While any key is
+* held the state is polled every activeInterval, after that the interval doubles up to idleInterval.
+* Intervals are in milliseconds. Edges are passed to the input function from the polling thread.
+*/
+bool PollerStart(unsigned int activeInterval, unsigned int idleInterval, PollInputFunc input);
+void PollerStop();
+
+void PollerGetStats(PollerStats* stats);
+void PollerResetStats();
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef QUIESCENCE_H
+#define QUIESCENCE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+/*
+* Lets threads we don't own, like the SDK callback thread, use the plugin state without taking a lock.
+* A caller pins the state with a single atomic increment on enter and releases it on leave. Closing the
+* gate turns away new callers and waits for the pinned ones to leave, after which the state can be freed.
+*/
+class QuiescenceGate {
+public:
+    constexpr QuiescenceGate() : state(CLOSED) {}
+
+    /* Callers that were just turned away may still be undoing their increment, so only clear the flag */
+    void open() {
+        state.fetch_and(~CLOSED, std::memory_order_release);
+    }
+
+    /* Returns false if the gate is closed, in which case leave must not be called */
+    bool enter() {
+        if (state.fetch_add(1, std::memory_order_acquire) & CLOSED) {
+            state.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    void leave() {
+        state.fetch_sub(1, std::memory_order_release);
+    }
+
+    /* Blocks until every caller that entered before the gate closed has left */
+    void close() {
+        state.fetch_or(CLOSED, std::memory_order_acq_rel);
+        while (state.load(std::memory_order_acquire) & ~CLOSED)
+            std::this_thread::yield();
+    }
+
+private:
+    static const uint32_t CLOSED = 0x80000000u;
+
+    std::atomic<uint32_t> state;
+};
+
+#endif
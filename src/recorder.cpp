@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include "recorder.h"
+#include "event_queue.h"
+
+#ifdef _WIN32
+#pragma warning (disable : 4996)  /* fopen is fine for the trace file */
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define RECORDER_QUEUE_SIZE 4096
+#define RECORDER_FLUSH_INTERVAL std::chrono::milliseconds(100)
+#define RECORDER_BATCH_SIZE 256
+
+static EventQueue recorderQueue;
+static FILE* recorderFile = NULL;
+static std::thread recorderThread;
+static std::atomic<bool> recording(false);
+static std::atomic<unsigned long long> recorderDropped(0);
+
+/* Used both by the recorder and the replay thread to wait for their next deadline or a stop request */
+static std::mutex stopMutex;
+static std::condition_variable stopCond;
+static bool recorderStopping = false;
+static bool replayStopping = false;
+
+static void RecorderFlush() {
+    GkeyEvent batch[RECORDER_BATCH_SIZE];
+    size_t count = 0;
+    while (recorderQueue.pop(&batch[count])) {
+        if (++count == RECORDER_BATCH_SIZE) {
+            fwrite(batch, sizeof(GkeyEvent), count, recorderFile);
+            count = 0;
+        }
+    }
+    if (count)
+        fwrite(batch, sizeof(GkeyEvent), count, recorderFile);
+    fflush(recorderFile);
+}
+
+static void RecorderRun() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!recorderStopping) {
+        stopCond.wait_for(lock, RECORDER_FLUSH_INTERVAL);
+        lock.unlock();
+        RecorderFlush();
+        lock.lock();
+    }
+}
+
+bool RecorderStart(const char* path) {
+    if (recording.load())
+        return false;
+    if (!recorderQueue.init(RECORDER_QUEUE_SIZE))
+        return false;
+
+    /* Writes in append mode always go to the end, earlier sessions are never overwritten */
+    recorderFile = fopen(path, "a+b");
+    if (!recorderFile) {
+        printf("PLUGIN: Failed to open trace file %s\n", path);
+        return false;
+    }
+
+    fseek(recorderFile, 0, SEEK_END);
+    const long size = ftell(recorderFile);
+    if (size > 0) {
+        TraceHeader header;
+        fseek(recorderFile, 0, SEEK_SET);
+        if (fread(&header, sizeof(header), 1, recorderFile) != 1 || header.magic != TRACE_MAGIC ||
+            header.version != TRACE_VERSION || (size - sizeof(header)) % sizeof(GkeyEvent) != 0) {
+            printf("PLUGIN: %s is not a G-Key trace file, not recording\n", path);
+            fclose(recorderFile);
+            recorderFile = NULL;
+            return false;
+        }
+    } else {
+        const TraceHeader header = { TRACE_MAGIC, TRACE_VERSION };
+        fwrite(&header, sizeof(header), 1, recorderFile);
+    }
+
+    const GkeyEvent session = { 0, TRACE_SESSION, GkeyTimestamp() };
+    fwrite(&session, sizeof(session), 1, recorderFile);
+
+    recorderStopping = false;
+    try {
+        recorderThread = std::thread(RecorderRun);
+    }
+    catch (const std::system_error&) {
+        fclose(recorderFile);
+        recorderFile = NULL;
+        return false;
+    }
+    recording.store(true, std::memory_order_release);
+    return true;
+}
+
+void RecorderStop() {
+    if (!recording.exchange(false))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        recorderStopping = true;
+    }
+    stopCond.notify_all();
+    recorderThread.join();
+
+    RecorderFlush();
+    fclose(recorderFile);
+    recorderFile = NULL;
+
+    if (recorderDropped.load())
+        printf("PLUGIN: Trace recorder dropped %llu events\n", recorderDropped.load());
+}
+
+void RecorderRecord(GkeyCode code) {
+    if (!recording.load(std::memory_order_acquire))
+        return;
+
+    GkeyEvent event = { GkeyCodeToRaw(code), 0, GkeyTimestamp() };
+    if (!recorderQueue.push(event))
+        recorderDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/* Read-only view of a whole trace file */
+struct MappedTrace {
+    const unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+static MappedTrace replayTrace;
+static std::thread replayThread;
+static std::atomic<bool> replaying(false);
+
+static bool MapTrace(const char* path, MappedTrace* trace) {
+    memset(trace, 0, sizeof(*trace));
+#ifdef _WIN32
+    trace->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (trace->file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(trace->file, &size) || size.QuadPart < (LONGLONG)sizeof(TraceHeader)) {
+        CloseHandle(trace->file);
+        return false;
+    }
+
+    trace->mapping = CreateFileMappingA(trace->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!trace->mapping) {
+        CloseHandle(trace->file);
+        return false;
+    }
+
+    trace->data = (const unsigned char*)MapViewOfFile(trace->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!trace->data) {
+        CloseHandle(trace->mapping);
+        CloseHandle(trace->file);
+        return false;
+    }
+    trace->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(TraceHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    trace->data = (const unsigned char*)data;
+    trace->size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+static void UnmapTrace(MappedTrace* trace) {
+    if (!trace->data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(trace->data);
+    CloseHandle(trace->mapping);
+    CloseHandle(trace->file);
+#else
+    munmap((void*)trace->data, trace->size);
+#endif
+    trace->data = NULL;
+}
+
+static void ReplayRun(bool realtime, ReplayFunc func) {
+    const size_t count = (replayTrace.size - sizeof(TraceHeader)) / sizeof(GkeyEvent);
+    const unsigned char* events = replayTrace.data + sizeof(TraceHeader);
+    if (count == 0)
+        return;
+
+    GkeyEvent first;
+    memcpy(&first, events, sizeof(first));
+    uint64_t base = first.timestamp;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < count; i++) {
+        GkeyEvent event;
+        memcpy(&event, events + i * sizeof(GkeyEvent), sizeof(event));
+
+        /* Each session has its own time base, continue right where the previous one ended */
+        if (event.reserved == TRACE_SESSION) {
+            base = event.timestamp;
+            start = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stopMutex);
+        if (realtime && event.timestamp > base)
+            stopCond.wait_until(lock, start + std::chrono::nanoseconds(event.timestamp - base), [] { return replayStopping; });
+        if (replayStopping)
+            return;
+        lock.unlock();
+
+        func(GkeyCodeFromRaw(event.code));
+    }
+}
+
+bool ReplayStart(const char* path, bool realtime, ReplayFunc func) {
+    if (replaying.load())
+        return false;
+
+    if (!MapTrace(path, &replayTrace)) {
+        printf("PLUGIN: Failed to map trace file %s\n", path);
+        return false;
+    }
+
+    TraceHeader header;
+    memcpy(&header, replayTrace.data, sizeof(header));
+    if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+        printf("PLUGIN: %s is not a G-Key trace file\n", path);
+        UnmapTrace(&replayTrace);
+        return false;
+    }
+
+    replayStopping = false;
+    try {
+        replayThread = std::thread(ReplayRun, realtime, func);
+    }
+    catch (const std::system_error&) {
+        UnmapTrace(&replayTrace);
+        return false;
+    }
+    replaying.store(true);
+    return true;
+}
+
+void ReplayStop() {
+    if (!replaying.exchange(false))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        replayStopping = true;
+    }
+    stopCond.notify_all();
+    replayThread.join();
+    UnmapTrace(&replayTrace);
+}
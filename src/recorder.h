@@ -0,0 +1,46 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+#include "gkey.h"
+
+/*
+* Trace files start with a TraceHeader followed by one GkeyEvent per key event,
+* all in native byte order with timestamps taken from GkeyTimestamp().
+* Every recording session is appended to the file and starts with a marker event whose reserved field is
+* TRACE_SESSION, as timestamps of different sessions can't be compared.
+*/
+#define TRACE_MAGIC 0x52544B47  /* "GKTR" */
+#define TRACE_VERSION 1
+#define TRACE_SESSION 1
+
+struct TraceHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+/*
+* Starts appending every recorded event to the given file from a background writer thread.
+* The header is only written to a new or empty file, existing files must be valid traces.
+*/
+bool RecorderStart(const char* path);
+
+/* Flushes all pending events and closes the trace file */
+void RecorderStop();
+
+/* Queues an event for the writer, never blocks. Must always be called from the same thread. */
+void RecorderRecord(GkeyCode code);
+
+/* Called from the replay thread for every event in the trace */
+typedef void (*ReplayFunc)(GkeyCode code);
+
+/*
+* Maps a trace file and feeds its events to the given function from a background thread,
+* either with their original spacing or as fast as possible. Sessions are replayed back to back.
+*/
+bool ReplayStart(const char* path, bool realtime, ReplayFunc func);
+
+/* Stops a replay that is still running and unmaps the trace */
+void ReplayStop();
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include "sdk_loader.h"
+
+#define SDK_RETRY_INITIAL std::chrono::milliseconds(250)
+#define SDK_RETRY_MAX std::chrono::milliseconds(30000)
+
+std::atomic<int> sdkState(SDK_STOPPED);
+
+static logiGkeyCBContext sdkContext;
+static logiGkeyCBContext* sdkContextPtr = NULL;
+static SdkReadyFunc readyFunc = NULL;
+static std::thread loaderThread;
+static std::mutex loaderMutex;
+static std::condition_variable loaderCond;
+static bool loaderStopping = false;
+
+static uint64_t startTime = 0;
+static std::atomic<uint64_t> readyLatency(0);
+static std::atomic<unsigned int> attempts(0);
+
+static void SdkRun(bool retry) {
+    std::chrono::milliseconds delay = SDK_RETRY_INITIAL;
+    for (;;) {
+        attempts.fetch_add(1, std::memory_order_relaxed);
+        if (LogiGkeyInit(sdkContextPtr)) {
+            readyLatency.store(GkeyTimestamp() - startTime);
+            sdkState.store(SDK_READY, std::memory_order_release);
+            if (readyFunc)
+                readyFunc();
+            return;
+        }
+
+        /* The Logitech software is not running (yet), wait before trying again */
+        if (!retry)
+            return;
+        std::unique_lock<std::mutex> lock(loaderMutex);
+        if (loaderCond.wait_for(lock, delay, [] { return loaderStopping; }))
+            return;
+        delay = delay * 2 < SDK_RETRY_MAX ? delay * 2 : SDK_RETRY_MAX;
+    }
+}
+
+void SdkStart(logiGkeyCBContext* context, SdkReadyFunc ready) {
+    if (context) {
+        sdkContext = *context;
+        sdkContextPtr = &sdkContext;
+    } else {
+        sdkContextPtr = NULL;
+    }
+    readyFunc = ready;
+    loaderStopping = false;
+    startTime = GkeyTimestamp();
+    readyLatency.store(0);
+    attempts.store(0);
+    sdkState.store(SDK_PENDING);
+
+    try {
+        loaderThread = std::thread(SdkRun, true);
+    }
+    catch (const std::system_error&) {
+        /* Fall back to a single attempt on the calling thread */
+        printf("PLUGIN: Failed to start the SDK loader thread\n");
+        SdkRun(false);
+    }
+}
+
+void SdkStop() {
+    if (sdkState.load() == SDK_STOPPED)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        loaderStopping = true;
+    }
+    loaderCond.notify_all();
+    if (loaderThread.joinable())
+        loaderThread.join();
+
+    if (sdkState.exchange(SDK_STOPPED) == SDK_READY)
+        LogiGkeyShutdown();
+}
+
+uint64_t SdkReadyLatency() {
+    return readyLatency.load();
+}
+
+unsigned int SdkAttempts() {
+    return attempts.load();
+}
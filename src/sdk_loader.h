@@ -0,0 +1,37 @@
+#ifndef SDK_LOADER_H
+#define SDK_LOADER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "gkey.h"
+
+enum SdkState {
+    SDK_STOPPED,
+    SDK_PENDING,  /* Waiting for the Logitech software to respond, retried with backoff */
+    SDK_READY,
+};
+
+extern std::atomic<int> sdkState;
+
+typedef void (*SdkReadyFunc)();
+
+/*
+* Initializes the G-key SDK on a background thread so the client does not wait for the Logitech software.
+* Failed attempts are retried with exponential backoff until the SDK is ready or SdkStop is called.
+* The ready function is called from the background thread once key events can arrive.
+* Without a callback context the SDK is initialized for polling.
+*/
+void SdkStart(logiGkeyCBContext* context, SdkReadyFunc ready);
+
+/* Cancels a pending initialization or shuts the SDK down, waiting for an attempt in progress to finish */
+void SdkStop();
+
+/* Nanoseconds from SdkStart until the SDK was ready, 0 if it is not ready yet */
+uint64_t SdkReadyLatency();
+unsigned int SdkAttempts();
+
+static inline bool SdkReady() {
+    return sdkState.load(std::memory_order_acquire) == SDK_READY;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include "stats.h"
+
+#ifdef _WIN32
+#define snprintf sprintf_s
+#endif
+
+#define STATS_LINE_SIZE 512
+
+std::atomic<bool> statsEnabled(false);
+
+static std::atomic<unsigned long long> eventCounts[GKEY_SLOT_COUNT];
+
+static struct {
+    std::atomic<unsigned long long> count;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> max;
+    std::atomic<unsigned long long> buckets[STATS_BUCKETS];
+} timers[STATS_TIMER_COUNT];
+
+static const char* const timerNames[STATS_TIMER_COUNT] = {
+    "notifyKeyEvent",
+    "Display name lookup",
+    "SDK name fetch",
+    "Direct input action",
+};
+
+static unsigned int BucketIndex(uint64_t nanoseconds) {
+    uint64_t microseconds = nanoseconds / 1000;
+    unsigned int bucket = 0;
+    while (microseconds && bucket < STATS_BUCKETS - 1) {
+        microseconds >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void StatsCountEvent(GkeyCode code) {
+    eventCounts[GKEY_SLOT(code)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void StatsRecordTime(StatsTimer timer, uint64_t nanoseconds) {
+    timers[timer].count.fetch_add(1, std::memory_order_relaxed);
+    timers[timer].total.fetch_add(nanoseconds, std::memory_order_relaxed);
+    timers[timer].buckets[BucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    AtomicMax(timers[timer].max, nanoseconds);
+}
+
+void StatsReset() {
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++)
+        eventCounts[slot].store(0, std::memory_order_relaxed);
+
+    for (unsigned int timer = 0; timer < STATS_TIMER_COUNT; timer++) {
+        timers[timer].count.store(0, std::memory_order_relaxed);
+        timers[timer].total.store(0, std::memory_order_relaxed);
+        timers[timer].max.store(0, std::memory_order_relaxed);
+        for (unsigned int bucket = 0; bucket < STATS_BUCKETS; bucket++)
+            timers[timer].buckets[bucket].store(0, std::memory_order_relaxed);
+    }
+}
+
+void StatsPrint(StatsPrintFunc print, StatsSlotNameFunc slotName) {
+    char line[STATS_LINE_SIZE];
+    int len = 0;
+
+    /* Per-key counts are packed several to a line, skipping keys that were never pressed */
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++) {
+        const unsigned long long count = eventCounts[slot].load(std::memory_order_relaxed);
+        if (!count)
+            continue;
+        if (len > STATS_LINE_SIZE - 64) {
+            print(line);
+            len = 0;
+        }
+        len += snprintf(line + len, STATS_LINE_SIZE - len, "%s%s: %llu", len ? ", " : "Events: ", slotName(slot), count);
+    }
+    if (len)
+        print(line);
+
+    for (unsigned int timer = 0; timer < STATS_TIMER_COUNT; timer++) {
+        const unsigned long long count = timers[timer].count.load(std::memory_order_relaxed);
+        if (!count)
+            continue;
+
+        len = snprintf(line, STATS_LINE_SIZE, "%s: %llu calls, avg %lluns, max %lluns |", timerNames[timer], count,
+            (unsigned long long)(timers[timer].total.load(std::memory_order_relaxed) / count),
+            (unsigned long long)timers[timer].max.load(std::memory_order_relaxed));
+        for (unsigned int bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+            const unsigned long long hits = timers[timer].buckets[bucket].load(std::memory_order_relaxed);
+            if (!hits)
+                continue;
+            if (bucket == STATS_BUCKETS - 1)
+                len += snprintf(line + len, STATS_LINE_SIZE - len, " >=%uus: %llu", 1u << (bucket - 1), hits);
+            else
+                len += snprintf(line + len, STATS_LINE_SIZE - len, " <%uus: %llu", 1u << bucket, hits);
+        }
+        print(line);
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <atomic>
+#include "gkey.h"
+
+enum StatsTimer {
+    STATS_NOTIFY,        /* Time spent inside notifyKeyEvent */
+    STATS_DISPLAY_NAME,  /* ts3plugin_displayKeyText lookups */
+    STATS_SDK_FETCH,     /* Fetching a key name from the SDK */
+    STATS_DIRECT_ACTION, /* Changing the input state directly for a bound key */
+    STATS_TIMER_COUNT
+};
+
+/* Latency histograms use power-of-two microsecond buckets, the last one collects everything slower */
+#define STATS_BUCKETS 16
+
+/* Instrumentation is off unless enabled in the settings, every hook checks this first */
+extern std::atomic<bool> statsEnabled;
+
+typedef void (*StatsPrintFunc)(const char* line);
+typedef const char* (*StatsSlotNameFunc)(unsigned int slot);
+
+void StatsCountEvent(GkeyCode code);
+void StatsRecordTime(StatsTimer timer, uint64_t nanoseconds);
+void StatsReset();
+
+/* Writes the per-key counters and latency histograms as text, one line at a time */
+void StatsPrint(StatsPrintFunc print, StatsSlotNameFunc slotName);
+
+static inline bool StatsEnabled() {
+    return statsEnabled.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <new>
+#include "timeline.h"
+#include "gkey.h"
+
+#ifdef _WIN32
+#pragma warning (disable : 4996)  /* fopen is fine for the timeline file */
+#endif
+
+/*
+* Every slot is guarded by a sequence number like a seqlock, it holds the index of the span plus one once
+* all fields are written and 0 while a writer is busy. A reader skips slots that changed while it read them.
+*/
+struct TimelineSlot {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> end;
+    std::atomic<uint64_t> info;  /* Span in the low 8 bits, thread in the next 24 and the key in the high 32 */
+};
+
+static const char* const spanNames[TIMELINE_SPAN_COUNT] = {
+    "Input",
+    "Queued",
+    "Identifier",
+    "notifyKeyEvent",
+    "displayKeyText",
+    "Direct action",
+};
+
+std::atomic<bool> timelineEnabled(false);
+
+static TimelineSlot* timelineRing = NULL;
+static uint64_t timelineMask = 0;
+static uint64_t timelineBase = 0;
+static std::atomic<uint64_t> timelineNext(0);
+static std::atomic<uint32_t> timelineThreads(0);
+
+/* Small sequential thread numbers are easier to tell apart in a trace viewer than native thread IDs */
+static uint32_t TimelineThread() {
+    static thread_local uint32_t thread = 0;
+    if (!thread)
+        thread = timelineThreads.fetch_add(1, std::memory_order_relaxed) + 1;
+    return thread;
+}
+
+bool TimelineStart(unsigned int capacity) {
+    if (timelineRing || !capacity)
+        return false;
+
+    uint64_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    timelineRing = new (std::nothrow) TimelineSlot[size];
+    if (!timelineRing) {
+        printf("PLUGIN: Failed to allocate the timeline for %u spans\n", capacity);
+        return false;
+    }
+    timelineMask = size - 1;
+    TimelineClear();
+    timelineEnabled.store(true);
+    return true;
+}
+
+/* Must only be called once nothing can record spans anymore */
+void TimelineStop() {
+    timelineEnabled.store(false);
+    delete[] timelineRing;
+    timelineRing = NULL;
+    timelineMask = 0;
+}
+
+void TimelineRecord(TimelineSpan span, uint64_t start, uint64_t end, uint32_t key) {
+    const uint64_t index = timelineNext.fetch_add(1, std::memory_order_relaxed);
+    TimelineSlot& slot = timelineRing[index & timelineMask];
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    slot.info.store((uint64_t)span | (uint64_t)(TimelineThread() & 0xFFFFFF) << 8 | (uint64_t)key << 32, std::memory_order_relaxed);
+    slot.seq.store(index + 1, std::memory_order_release);
+}
+
+void TimelineClear() {
+    if (!timelineRing)
+        return;
+    for (uint64_t i = 0; i <= timelineMask; i++)
+        timelineRing[i].seq.store(0, std::memory_order_relaxed);
+    timelineBase = GkeyTimestamp();
+    timelineNext.store(0);
+}
+
+long TimelineWrite(const char* path, TimelineKeyNameFunc keyName) {
+    if (!timelineRing)
+        return -1;
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("PLUGIN: Failed to open timeline file %s\n", path);
+        return -1;
+    }
+
+    /* Spans keep being recorded while writing, only the ones that are not overwritten in the meantime are written */
+    const uint64_t next = timelineNext.load(std::memory_order_acquire);
+    const uint64_t first = next > timelineMask + 1 ? next - (timelineMask + 1) : 0;
+    long written = 0;
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    for (uint64_t index = first; index < next; index++) {
+        const TimelineSlot& slot = timelineRing[index & timelineMask];
+        const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != index + 1)
+            continue;
+        const uint64_t start = slot.start.load(std::memory_order_relaxed);
+        const uint64_t end = slot.end.load(std::memory_order_relaxed);
+        const uint64_t info = slot.info.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+            continue;
+
+        const unsigned int span = (unsigned int)(info & 0xFF);
+        const unsigned int thread = (unsigned int)(info >> 8 & 0xFFFFFF);
+        const uint32_t key = (uint32_t)(info >> 32);
+        if (span >= TIMELINE_SPAN_COUNT || start < timelineBase)
+            continue;
+
+        /* Timestamps are in microseconds relative to the start of the timeline */
+        fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"gkey\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+            written ? "," : "", spanNames[span], thread,
+            (start - timelineBase) / 1000.0, (end > start ? end - start : 0) / 1000.0);
+        const char* name = key != TIMELINE_NO_KEY ? keyName(key) : NULL;
+        if (name)
+            fprintf(file, ",\"args\":{\"key\":\"%s\"}", name);
+        fputc('}', file);
+        written++;
+    }
+    fputs("\n]}\n", file);
+
+    if (fclose(file) != 0) {
+        printf("PLUGIN: Failed to write timeline file %s\n", path);
+        return -1;
+    }
+    return written;
+}
@@ -0,0 +1,42 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdint.h>
+#include <atomic>
+
+enum TimelineSpan {
+    TIMELINE_INPUT,         /* A key event arriving from the SDK or another backend */
+    TIMELINE_QUEUED,        /* Time an event waited for the dispatcher thread */
+    TIMELINE_IDENTIFIER,    /* Resolving the identifier or action of a key */
+    TIMELINE_NOTIFY,        /* Time spent inside notifyKeyEvent */
+    TIMELINE_DISPLAY_NAME,  /* ts3plugin_displayKeyText lookups */
+    TIMELINE_DIRECT_ACTION, /* Changing the input state directly for a bound key */
+    TIMELINE_SPAN_COUNT
+};
+
+/* Marks a span that is not about a particular key */
+#define TIMELINE_NO_KEY 0xFFFFFFFFu
+
+/* Recording is off unless enabled in the settings, every hook checks this first */
+extern std::atomic<bool> timelineEnabled;
+
+typedef const char* (*TimelineKeyNameFunc)(uint32_t key);
+
+/* Allocates a ring holding the given number of spans, the oldest ones are overwritten once it is full */
+bool TimelineStart(unsigned int capacity);
+void TimelineStop();
+
+/* Records a span in nanoseconds on the GkeyTimestamp clock, safe to call from any thread */
+void TimelineRecord(TimelineSpan span, uint64_t start, uint64_t end, uint32_t key);
+
+/* Drops all recorded spans */
+void TimelineClear();
+
+/* Writes the recorded spans to a file in the Chrome trace event format, returns the number of spans written or -1 */
+long TimelineWrite(const char* path, TimelineKeyNameFunc keyName);
+
+static inline bool TimelineEnabled() {
+    return timelineEnabled.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include <atomic>
+#include "timer_wheel.h"
+
+/*
+* Hierarchical timing wheel with four levels of 64 buckets, covering about 4.6 hours at a 1ms resolution.
+* A timer sits in the lowest level whose range covers its deadline and moves down a level whenever the wheel
+* passes the start of its bucket, so advancing only ever touches the timers that are due or about to be.
+*/
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1u << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1ULL << (WHEEL_BITS * WHEEL_LEVELS))
+#define WHEEL_NONE 0xFFFF
+
+/* Timers are intrusive doubly linked lists indexed by slot so cancelling never has to search a bucket */
+static uint16_t bucketHeads[WHEEL_LEVELS * WHEEL_SIZE];
+static uint16_t nextTimer[GKEY_SLOT_COUNT];
+static uint16_t prevTimer[GKEY_SLOT_COUNT];
+static uint16_t timerBuckets[GKEY_SLOT_COUNT];  /* WHEEL_NONE while the timer is not pending */
+static uint64_t timerExpiry[GKEY_SLOT_COUNT];   /* Deadline in ticks */
+static uint64_t timerDeadlines[GKEY_SLOT_COUNT];
+static uint64_t wheelTick = 0;                  /* Last tick whose timers have expired */
+static unsigned int activeCount = 0;
+
+static std::atomic<unsigned long long> firedCount(0);
+static std::atomic<uint64_t> totalJitter(0), maxJitter(0), advanceTime(0);
+static std::atomic<unsigned int> maxActive(0);
+
+static void Link(unsigned int slot, uint64_t base) {
+    const uint64_t delta = timerExpiry[slot] - base;
+    const uint64_t expiry = delta < WHEEL_RANGE ? timerExpiry[slot] : base + WHEEL_RANGE - 1;
+
+    unsigned int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= 1ULL << (WHEEL_BITS * (level + 1)))
+        level++;
+    const unsigned int bucket = level * WHEEL_SIZE + (unsigned int)((expiry >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1));
+
+    prevTimer[slot] = WHEEL_NONE;
+    nextTimer[slot] = bucketHeads[bucket];
+    if (bucketHeads[bucket] != WHEEL_NONE)
+        prevTimer[bucketHeads[bucket]] = (uint16_t)slot;
+    bucketHeads[bucket] = (uint16_t)slot;
+    timerBuckets[slot] = (uint16_t)bucket;
+}
+
+static void Unlink(unsigned int slot) {
+    if (prevTimer[slot] != WHEEL_NONE)
+        nextTimer[prevTimer[slot]] = nextTimer[slot];
+    else
+        bucketHeads[timerBuckets[slot]] = nextTimer[slot];
+    if (nextTimer[slot] != WHEEL_NONE)
+        prevTimer[nextTimer[slot]] = prevTimer[slot];
+    timerBuckets[slot] = WHEEL_NONE;
+}
+
+void TimerWheelInit(uint64_t now) {
+    for (unsigned int bucket = 0; bucket < WHEEL_LEVELS * WHEEL_SIZE; bucket++)
+        bucketHeads[bucket] = WHEEL_NONE;
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++)
+        timerBuckets[slot] = WHEEL_NONE;
+    wheelTick = now / TIMER_WHEEL_TICK;
+    activeCount = 0;
+}
+
+void TimerWheelSchedule(unsigned int slot, uint64_t now, uint64_t deadline) {
+    /* Skip the ticks that passed while the wheel was empty instead of stepping through them on the next advance */
+    if (!activeCount && now / TIMER_WHEEL_TICK > wheelTick)
+        wheelTick = now / TIMER_WHEEL_TICK;
+
+    if (timerBuckets[slot] != WHEEL_NONE)
+        Unlink(slot);
+    else
+        AtomicMax(maxActive, ++activeCount);
+
+    const uint64_t expiry = (deadline + TIMER_WHEEL_TICK - 1) / TIMER_WHEEL_TICK;
+    timerExpiry[slot] = expiry > wheelTick ? expiry : wheelTick + 1;
+    timerDeadlines[slot] = deadline;
+    Link(slot, wheelTick);
+}
+
+void TimerWheelCancel(unsigned int slot) {
+    if (timerBuckets[slot] == WHEEL_NONE)
+        return;
+    Unlink(slot);
+    activeCount--;
+}
+
+bool TimerWheelPending(unsigned int slot) {
+    return timerBuckets[slot] != WHEEL_NONE;
+}
+
+uint64_t TimerWheelAdvance(uint64_t now, TimerWheelExpireFunc expire) {
+    const uint64_t target = now / TIMER_WHEEL_TICK;
+    if (!activeCount) {
+        if (target > wheelTick)
+            wheelTick = target;
+        return 0;
+    }
+
+    const uint64_t start = GkeyTimestamp();
+    while (wheelTick < target) {
+        const uint64_t tick = wheelTick + 1;
+
+        /* Move the timers of every higher level bucket that starts at this tick down the wheel, top level first */
+        for (unsigned int level = WHEEL_LEVELS - 1; level > 0; level--) {
+            if (tick & ((1ULL << (WHEEL_BITS * level)) - 1))
+                continue;
+            const unsigned int bucket = level * WHEEL_SIZE + (unsigned int)((tick >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1));
+            while (bucketHeads[bucket] != WHEEL_NONE) {
+                const unsigned int slot = bucketHeads[bucket];
+                Unlink(slot);
+                Link(slot, tick);
+            }
+        }
+        wheelTick = tick;
+
+        /* Timers can't be scheduled into the bucket being expired, but an expiring timer may cancel another one */
+        const unsigned int bucket = (unsigned int)(tick & (WHEEL_SIZE - 1));
+        while (bucketHeads[bucket] != WHEEL_NONE) {
+            const unsigned int slot = bucketHeads[bucket];
+            Unlink(slot);
+            activeCount--;
+
+            const uint64_t deadline = timerDeadlines[slot];
+            const uint64_t jitter = now > deadline ? now - deadline : 0;
+            firedCount.fetch_add(1, std::memory_order_relaxed);
+            totalJitter.fetch_add(jitter, std::memory_order_relaxed);
+            AtomicMax(maxJitter, jitter);
+            expire(slot, deadline);
+        }
+
+        if (!activeCount) {
+            wheelTick = target;
+            break;
+        }
+    }
+    advanceTime.fetch_add(GkeyTimestamp() - start, std::memory_order_relaxed);
+
+    if (!activeCount)
+        return 0;
+
+    /* A timer cascading down at the next revolution may be due before anything that is in the lowest level now */
+    const uint64_t cascade = (wheelTick | (WHEEL_SIZE - 1)) + 1;
+    for (uint64_t tick = wheelTick + 1; tick < cascade; tick++) {
+        if (bucketHeads[tick & (WHEEL_SIZE - 1)] != WHEEL_NONE)
+            return tick * TIMER_WHEEL_TICK;
+    }
+    return cascade * TIMER_WHEEL_TICK;
+}
+
+void TimerWheelGetStats(TimerWheelStats* stats) {
+    stats->fired = firedCount.load();
+    stats->totalJitter = totalJitter.load();
+    stats->maxJitter = maxJitter.load();
+    stats->advanceTime = advanceTime.load();
+    stats->maxActive = maxActive.load();
+}
+
+void TimerWheelResetStats() {
+    firedCount.store(0);
+    totalJitter.store(0);
+    maxJitter.store(0);
+    advanceTime.store(0);
+    maxActive.store(0);
+}
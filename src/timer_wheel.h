@@ -0,0 +1,42 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include "gkey.h"
+
+/* Resolution of the wheel, deadlines are rounded up to the next tick so timers never fire early */
+#define TIMER_WHEEL_TICK 1000000ULL
+
+struct TimerWheelStats {
+    unsigned long long fired;
+    uint64_t totalJitter;   /* Sum of the delays between deadlines and their expiry in nanoseconds */
+    uint64_t maxJitter;
+    uint64_t advanceTime;   /* Time spent advancing the wheel in nanoseconds */
+    unsigned int maxActive; /* Most timers pending at once */
+};
+
+/* Called for every timer that expired, it may schedule the same timer again */
+typedef void (*TimerWheelExpireFunc)(unsigned int slot, uint64_t deadline);
+
+/* Cancels all timers and starts the wheel at the given time */
+void TimerWheelInit(uint64_t now);
+
+/*
+* There is one timer per key slot, scheduling one that is already pending moves it. All functions must be
+* called from the dispatcher thread, scheduling and cancelling take constant time. The wheel isn't advanced
+* while it is empty, so scheduling takes the current time to catch up with it first.
+*/
+void TimerWheelSchedule(unsigned int slot, uint64_t now, uint64_t deadline);
+void TimerWheelCancel(unsigned int slot);
+bool TimerWheelPending(unsigned int slot);
+
+/*
+* Expires every timer whose deadline has passed. Returns the timestamp at which the wheel needs to be advanced
+* again, which may be before the next deadline when timers have to move down the wheel, or 0 if none are pending.
+*/
+uint64_t TimerWheelAdvance(uint64_t now, TimerWheelExpireFunc expire);
+
+void TimerWheelGetStats(TimerWheelStats* stats);
+void TimerWheelResetStats();
+
+#endif
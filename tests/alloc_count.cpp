@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include "alloc_count.h"
+
+#if defined(__has_feature)
+#if __has_feature(thread_sanitizer) || __has_feature(address_sanitizer)
+#define ALLOC_COUNT_SANITIZED
+#endif
+#endif
+#if defined(__SANITIZE_THREAD__) || defined(__SANITIZE_ADDRESS__)
+#define ALLOC_COUNT_SANITIZED
+#endif
+
+static std::atomic<unsigned long long> allocations(0);
+
+#if defined(__GLIBC__) && !defined(ALLOC_COUNT_SANITIZED)
+/* Defining these in the executable interposes them for the shared libraries as well */
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) __THROW {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) __THROW {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+bool AllocCountSupported() {
+    return true;
+}
+#else
+bool AllocCountSupported() {
+    return false;
+}
+#endif
+
+unsigned long long AllocCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
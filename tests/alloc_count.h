@@ -0,0 +1,13 @@
+#ifndef ALLOC_COUNT_H
+#define ALLOC_COUNT_H
+
+#include <atomic>
+
+/*
+* Counts the calls to malloc, calloc and realloc of the whole process, including those made by the plugin and
+* operator new. Only supported with glibc and without sanitizers, which bring their own allocator.
+*/
+bool AllocCountSupported();
+unsigned long long AllocCount();
+
+#endif
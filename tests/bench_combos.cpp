@@ -0,0 +1,106 @@
+/*
+* Per-event cost of matching chords and sequences, measured as the SDK callback latency with direct dispatch
+* and an increasing number of combos. Also checks that combos are numbered in the order of the settings file.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "ts3_functions.h"
+#include "plugin.h"
+#include "host.h"
+
+#define EVENTS 200000
+#define KEYS 18
+
+static std::string Key(unsigned int index) {
+    return "keybd-g" + std::to_string(1 + index % KEYS) + "-m" + std::to_string(1 + index / KEYS % 3);
+}
+
+/* Half chords over two neighbouring keys, half sequences over three */
+static std::string ComboSettings(unsigned int combos) {
+    std::string settings = "queue_capacity = 0\n";
+    for (unsigned int i = 0; i < combos; i++) {
+        const unsigned int key = i / 2 * 3;
+        if (i & 1)
+            settings += "sequence = " + Key(key) + ", " + Key(key + 1) + ", " + Key(key + 2) + "\n";
+        else
+            settings += "chord = " + Key(key) + " + " + Key(key + 1) + "\n";
+    }
+    return settings;
+}
+
+static GkeyCode KeyCode(unsigned int index, bool down) {
+    return HostKey(1 + index % KEYS, 1 + index / KEYS % 3, down);
+}
+
+static void BenchMatching(unsigned int combos) {
+    if (!HostStart(ComboSettings(combos).c_str()))
+        return;
+
+    /* Rolls over neighbouring keys so chords and sequences keep matching */
+    LatencySamples samples(EVENTS);
+    const unsigned long long before = hostNotifications.load();
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < EVENTS / 4; i++) {
+        const GkeyCode codes[] = { KeyCode(i, true), KeyCode(i + 1, true), KeyCode(i, false), KeyCode(i + 1, false) };
+        for (size_t j = 0; j < 4; j++) {
+            const uint64_t t0 = HostTimestamp();
+            MockGkeyEvent(codes[j]);
+            samples.add(HostTimestamp() - t0);
+        }
+    }
+    const uint64_t wallTime = HostTimestamp() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "SDK callback, %u combos", combos);
+    samples.report(name, wallTime);
+    const unsigned long long matches = hostNotifications.load() - before - EVENTS;
+    printf("    %llu combo notifications\n", matches);
+    HostCheck(combos == 0 || matches > 0, "combos match");
+    HostStop();
+}
+
+static std::string lastIdentifier;
+
+static void RecordIdentifier(const char* keyIdentifier, bool down) {
+    if (down)
+        lastIdentifier = keyIdentifier;
+}
+
+static void CheckNumbering() {
+    const char* settings =
+        "queue_capacity = 0\n"
+        "sequence = keybd-g1-m1, keybd-g2-m1\n"
+        "chord = keybd-g3-m1 + keybd-g4-m1\n"
+        "chord = keybd-g5-m1 + keybd-g99999-m1\n"
+        "sequence = keybd-g6-m1, keybd-g7-m1\n";
+    if (!HostStart(settings))
+        return;
+    HostCheck(strcmp(ts3plugin_displayKeyText("combo-1"), "keybd-g1-m1, keybd-g2-m1") == 0, "the first line is combo-1");
+    HostCheck(strcmp(ts3plugin_displayKeyText("combo-2"), "keybd-g3-m1 + keybd-g4-m1") == 0, "chords keep their place among sequences");
+    HostCheck(strcmp(ts3plugin_displayKeyText("combo-3"), "combo-3") == 0, "invalid combos aren't defined");
+    HostCheck(strcmp(ts3plugin_displayKeyText("combo-4"), "keybd-g6-m1, keybd-g7-m1") == 0, "invalid combos keep their number");
+    HostCheck(strcmp(ts3plugin_displayKeyText("combo-04"), "combo-04") == 0, "non-canonical combo identifiers are rejected");
+
+    HostSetNotifyFunc(RecordIdentifier);
+    MockGkeyKey(3, 1, true);
+    MockGkeyKey(4, 1, true);
+    MockGkeyKey(4, 1, false);
+    MockGkeyKey(3, 1, false);
+    HostCheck(lastIdentifier == "combo-2", "the chord is notified as combo-2");
+    MockGkeyKey(6, 1, true);
+    MockGkeyKey(6, 1, false);
+    MockGkeyKey(7, 1, true);
+    MockGkeyKey(7, 1, false);
+    HostCheck(lastIdentifier == "combo-4", "the sequence is notified as combo-4");
+    HostSetNotifyFunc(NULL);
+    HostStop();
+}
+
+int main() {
+    CheckNumbering();
+    BenchMatching(0);
+    BenchMatching(16);
+    BenchMatching(64);
+    return HostExitCode();
+}
@@ -0,0 +1,67 @@
+/*
+* Client notifications caused by noisy input with and without the debounce stage. Every press repeats its
+* key-down like the Logitech software does for held keys, and both edges chatter like a worn mouse switch.
+* Before the debounce stage every one of these edges reached notifyKeyEvent.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "host.h"
+
+#define PRESSES 60
+#define HOLD std::chrono::milliseconds(8)  /* Longer than the 5ms debounce window */
+
+static GkeyCode NoisyKey(unsigned int press, bool down) {
+    GkeyCode code = HostKey(1 + press % LOGITECH_MAX_GKEYS, 1, down);
+    if (press & 1) {
+        code.mouse = 1;
+        code.keyIdx = 6 + press % 4;
+        code.mState = 0;
+    }
+    return code;
+}
+
+/* Sends the noisy presses and returns the number of raw edges */
+static unsigned int SendNoisyPresses() {
+    unsigned int edges = 0;
+    for (unsigned int press = 0; press < PRESSES; press++) {
+        /* Press with a repeated key-down and chatter */
+        const bool pressEdges[] = { true, true, false, true, false, true };
+        for (size_t i = 0; i < sizeof(pressEdges); i++, edges++)
+            MockGkeyEvent(NoisyKey(press, pressEdges[i]));
+        std::this_thread::sleep_for(HOLD);
+
+        /* Release with chatter */
+        const bool releaseEdges[] = { false, true, false, true, false };
+        for (size_t i = 0; i < sizeof(releaseEdges); i++, edges++)
+            MockGkeyEvent(NoisyKey(press, releaseEdges[i]));
+        std::this_thread::sleep_for(HOLD);
+    }
+    return edges;
+}
+
+static void BenchNoise(const char* name, const char* settings, unsigned long long expected) {
+    if (!HostStart(settings))
+        return;
+    const unsigned long long before = hostNotifications.load();
+    const unsigned int edges = SendNoisyPresses();
+    HostWaitFor(hostNotifications, before + expected, 5000);
+
+    /* Give late settled edges a chance to show up */
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const unsigned long long notifications = hostNotifications.load() - before;
+    printf("%-36s %5u edges -> %5llu notifications (%.1f per press, %.0f%% suppressed)\n", name, edges, notifications,
+        (double)notifications / PRESSES, 100.0 * (double)(edges - notifications) / edges);
+    HostCommand("stats", "Debounce:");
+    HostStop();
+
+    HostCheck(notifications == expected, name);
+}
+
+int main() {
+    /* Repeated key-downs are always dropped, only the chatter gets through without a window */
+    BenchNoise("duplicate edges only", "queue_capacity = 256\n", PRESSES * 10ull);
+    BenchNoise("5ms debounce", "queue_capacity = 256\ndebounce_keyboard_ms = 5\ndebounce_mouse_ms = 5\n", PRESSES * 2ull);
+    return HostExitCode();
+}
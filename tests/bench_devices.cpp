@@ -0,0 +1,134 @@
+/*
+* Lookup and dispatch cost as the number of devices and keys grows. Identifiers are looked up through
+* ts3plugin_keyDeviceName and ts3plugin_displayKeyText, and replayed traces spread their key events over
+* every device so dispatch goes through the per-device state tables.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "ts3_functions.h"
+#include "plugin.h"
+#include "host.h"
+#include "gkey.h"
+#include "recorder.h"
+#include "event_queue.h"
+
+#define LOOKUPS 200000
+#define EVENTS 400000
+
+/* Every keyboard G-key in every M-state and every mouse button of the first devices */
+static std::vector<GkeyCode> DeviceKeys(unsigned int devices) {
+    std::vector<GkeyCode> keys;
+    for (unsigned int device = 0; device < devices; device++) {
+        for (unsigned int gkey = 1; gkey <= LOGITECH_MAX_GKEYS; gkey++) {
+            for (unsigned int mode = 1; mode <= LOGITECH_MAX_M_STATES; mode++) {
+                GkeyCode code = HostKey(gkey, mode, true);
+                code.reserved1 = device;
+                keys.push_back(code);
+            }
+        }
+        for (unsigned int button = 1; button <= LOGITECH_MAX_MOUSE_BUTTONS; button++) {
+            GkeyCode code = HostKey(button, 0, true);
+            code.mouse = 1;
+            code.reserved1 = device;
+            keys.push_back(code);
+        }
+    }
+    return keys;
+}
+
+static std::string Identifier(GkeyCode code) {
+    std::string identifier = code.mouse ? "mouse" : "keybd";
+    if (code.reserved1)
+        identifier += std::to_string(code.reserved1 + 1);
+    return identifier + "-g" + std::to_string(code.keyIdx) + "-m" + std::to_string(code.mState);
+}
+
+static uint64_t BenchLookup(const char* name, const char* (*lookup)(const char*), const std::vector<GkeyCode>& keys) {
+    std::vector<std::string> identifiers;
+    for (const GkeyCode& code : keys)
+        identifiers.push_back(Identifier(code));
+
+    LatencySamples samples(LOOKUPS);
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        const char* identifier = identifiers[i % identifiers.size()].c_str();
+        const uint64_t t0 = HostTimestamp();
+        const char* result = lookup(identifier);
+        samples.add(HostTimestamp() - t0);
+        if (!result || !*result) {
+            HostCheck(false, "lookups return a name");
+            break;
+        }
+    }
+    char label[96];
+    snprintf(label, sizeof(label), "%s, %u keys", name, (unsigned int)keys.size());
+    samples.report(label, HostTimestamp() - start);
+    return samples.percentile(0.5);
+}
+
+/* Replays presses and releases over all the keys as fast as possible, returns the nanoseconds per event */
+static double BenchDispatch(const std::vector<GkeyCode>& keys) {
+    char path[] = "/tmp/gkey_trace_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd == -1)
+        return 0;
+    std::vector<unsigned char> trace(sizeof(TraceHeader) + EVENTS * sizeof(GkeyEvent));
+    const TraceHeader header = { TRACE_MAGIC, TRACE_VERSION };
+    memcpy(&trace[0], &header, sizeof(header));
+    for (unsigned int i = 0; i < EVENTS; i++) {
+        GkeyCode code = keys[(i / 2) % keys.size()];
+        code.keyDown = !(i & 1);
+        const GkeyEvent event = { GkeyCodeToRaw(code), 0, i * 1000ull };
+        memcpy(&trace[sizeof(header) + i * sizeof(GkeyEvent)], &event, sizeof(event));
+    }
+    HostCheck(write(fd, trace.data(), trace.size()) == (ssize_t)trace.size(), "the trace is written");
+    close(fd);
+
+    const std::string settings = std::string("queue_capacity = 0\nreplay_realtime = false\nreplay_file = ") + path + "\n";
+    double perEvent = 0;
+    const unsigned long long before = hostNotifications.load();
+    if (HostInit(settings.c_str())) {
+        const uint64_t start = HostTimestamp();
+        HostRegister();
+        HostCheck(HostWaitFor(hostNotifications, before + EVENTS, 10000), "every replayed event is notified");
+        perEvent = (double)(HostTimestamp() - start) / EVENTS;
+        HostStop();
+    }
+    unlink(path);
+
+    printf("%-43s %6u keys %8.1fns per event\n", "replay dispatch", (unsigned int)keys.size(), perEvent);
+    return perEvent;
+}
+
+int main() {
+    const unsigned int devices[] = { 1, 2, 4 };
+    uint64_t deviceName[3], displayText[3];
+    double dispatch[3];
+
+    for (size_t i = 0; i < 3; i++) {
+        printf("%u device%s\n", devices[i], devices[i] > 1 ? "s" : "");
+        const std::vector<GkeyCode> keys = DeviceKeys(devices[i]);
+        if (!HostStart("queue_capacity = 0\n"))
+            return HostExitCode();
+        deviceName[i] = BenchLookup("ts3plugin_keyDeviceName", ts3plugin_keyDeviceName, keys);
+        displayText[i] = BenchLookup("ts3plugin_displayKeyText", ts3plugin_displayKeyText, keys);
+        HostStop();
+        dispatch[i] = BenchDispatch(keys);
+    }
+
+    /* Generous bounds, the costs should be about the same but timings on a busy machine are noisy */
+    HostCheck(deviceName[2] <= 4 * deviceName[0] + 100, "device name lookups stay flat");
+    HostCheck(displayText[2] <= 4 * displayText[0] + 100, "display name lookups stay flat");
+    HostCheck(dispatch[2] <= 4 * dispatch[0] + 100, "dispatch stays flat");
+
+    /* Keys on other devices don't collide with the first one */
+    if (HostStart("queue_capacity = 0\n")) {
+        HostCheck(strcmp(ts3plugin_keyDeviceName("keybd-g1-m1"), ts3plugin_keyDeviceName("keybd2-g1-m1")) != 0,
+            "devices have their own names");
+        HostStop();
+    }
+    return HostExitCode();
+}
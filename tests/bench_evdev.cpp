@@ -0,0 +1,148 @@
+/*
+* Throughput and latency of the evdev backend reading recorded input_event streams from a pipe. The writer
+* sends the records in batches like a device with several keys changing at once, and one press at a time
+* to measure the latency from write() to notifyKeyEvent.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include "host.h"
+
+#ifndef KEY_MACRO1
+#define KEY_MACRO1 0x290
+#endif
+
+#define PRESSES 100000
+#define LATENCY_PRESSES 20000
+#define KEYS 18
+
+/* A key edge followed by its SYN_REPORT, as written by the kernel */
+static void AddEdge(std::vector<struct input_event>& records, unsigned int key, bool down) {
+    struct input_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = EV_KEY;
+    event.code = (unsigned short)(KEY_MACRO1 + key % KEYS);
+    event.value = down ? 1 : 0;
+    records.push_back(event);
+    event.type = EV_SYN;
+    event.code = SYN_REPORT;
+    event.value = 0;
+    records.push_back(event);
+}
+
+static bool WriteAll(int fd, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    while (size) {
+        const ssize_t written = write(fd, p, size);
+        if (written <= 0)
+            return false;
+        p += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/* Starts the plugin on a new pipe and returns its writing end */
+static int StartPipe(const char* settings) {
+    /* The pipe has to exist before the plugin opens it, so it can't live in the config directory */
+    char fifo[64];
+    snprintf(fifo, sizeof(fifo), "/tmp/gkey_evdev_%d", (int)getpid());
+    unlink(fifo);
+    if (mkfifo(fifo, 0600) != 0) {
+        perror("mkfifo");
+        return -1;
+    }
+
+    const std::string config = std::string(settings) + "backend = evdev\nevdev_device = " + fifo + "\n";
+    if (!HostStart(config.c_str())) {
+        unlink(fifo);
+        return -1;
+    }
+    const int fd = open(fifo, O_WRONLY);
+    unlink(fifo);
+    return fd;
+}
+
+static void BenchThroughput(const char* name, unsigned int batch) {
+    const int fd = StartPipe("queue_capacity = 4096\n");
+    if (fd == -1)
+        return;
+    HostCommand("reset", NULL);
+
+    /* Each batch holds whole presses so the queue never sees more than one batch in flight */
+    std::vector<struct input_event> records;
+    for (unsigned int i = 0; i < PRESSES; i++) {
+        AddEdge(records, i, true);
+        AddEdge(records, i, false);
+    }
+    const size_t recordsPerWrite = batch * 4;
+
+    LatencySamples samples(records.size() / recordsPerWrite + 1);
+    const unsigned long long before = hostNotifications.load();
+    const uint64_t start = HostTimestamp();
+    for (size_t i = 0; i < records.size(); i += recordsPerWrite) {
+        const size_t count = records.size() - i < recordsPerWrite ? records.size() - i : recordsPerWrite;
+        const uint64_t t0 = HostTimestamp();
+        if (!WriteAll(fd, &records[i], count * sizeof(struct input_event)))
+            break;
+        const unsigned long long expected = before + (i + count) / 2;
+        if (!HostWaitFor(hostNotifications, expected, 5000))
+            break;
+        samples.add(HostTimestamp() - t0);
+    }
+    const uint64_t wallTime = HostTimestamp() - start;
+    close(fd);
+
+    HostCheck(hostNotifications.load() - before == 2ull * PRESSES, "every key edge is notified");
+    samples.report(name, wallTime);
+    printf("    %.0f key edges/s\n", 2.0 * PRESSES / ((double)wallTime / 1e9));
+    HostCommand("stats", "Evdev:");
+    HostStop();
+}
+
+static std::atomic<uint64_t> notifiedAt(0);
+
+static void RecordNotify(const char* keyIdentifier, bool down) {
+    notifiedAt.store(HostTimestamp(), std::memory_order_release);
+}
+
+static void BenchLatency(const char* name, const char* settings) {
+    const int fd = StartPipe(settings);
+    if (fd == -1)
+        return;
+
+    HostSetNotifyFunc(RecordNotify);
+    LatencySamples samples(LATENCY_PRESSES);
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < LATENCY_PRESSES; i++) {
+        std::vector<struct input_event> records;
+        AddEdge(records, i / 2, !(i & 1));
+        const unsigned long long before = hostNotifications.load();
+        const uint64_t t0 = HostTimestamp();
+        if (!WriteAll(fd, &records[0], records.size() * sizeof(struct input_event)))
+            break;
+        if (!HostWaitFor(hostNotifications, before + 1, 5000))
+            break;
+        samples.add(notifiedAt.load(std::memory_order_acquire) - t0);
+    }
+    const uint64_t wallTime = HostTimestamp() - start;
+    HostSetNotifyFunc(NULL);
+    close(fd);
+
+    HostCheck(samples.count() == LATENCY_PRESSES, "every key edge is notified");
+    samples.report(name, wallTime);
+    HostStop();
+}
+
+int main() {
+    BenchThroughput("pipe write, 1 press per write", 1);
+    BenchThroughput("pipe write, 16 presses per write", 16);
+    BenchLatency("pipe write to notifyKeyEvent, direct", "queue_capacity = 0\n");
+    BenchLatency("pipe write to notifyKeyEvent, dispatcher", "");
+    return HostExitCode();
+}
@@ -0,0 +1,183 @@
+/*
+* Cost of building and parsing key identifiers before and after they were precomputed. The old paths are
+* reproduced here as they were: the SDK callback formatted the identifier with snprintf on every event, and
+* ts3plugin_displayKeyText tokenized a heap copy of it and converted the SDK name to UTF-8 on every call.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ts3_functions.h"
+#include "plugin.h"
+#include "host.h"
+#include "alloc_count.h"
+
+#define EVENTS 200000
+#define LOOKUPS 200000
+
+/* Reports the latency followed by the allocations per operation */
+static void Report(const char* name, LatencySamples& samples, uint64_t wallTime, unsigned long long allocations) {
+    samples.report(name, wallTime);
+    if (AllocCountSupported())
+        printf("    %.2f allocations per call\n", (double)allocations / samples.count());
+}
+
+/* The old SDK callback, notifyKeyEvent is replaced by a counter */
+static std::atomic<unsigned long long> oldNotifications(0);
+
+static void OldNotifyKeyEvent(const char* pluginID, const char* keyIdentifier, int up_down) {
+    if (keyIdentifier[0])
+        oldNotifications.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void (*volatile oldNotify)(const char*, const char*, int) = OldNotifyKeyEvent;
+
+static void OldSDKCallback(GkeyCode gkeyCode) {
+    char keyId[64];
+    snprintf(keyId, sizeof(keyId), "%s-g%d-m%d", gkeyCode.mouse ? "mouse" : "keybd", gkeyCode.keyIdx, gkeyCode.mState);
+    oldNotify("gkey_plugin_host", keyId, !gkeyCode.keyDown);
+}
+
+/* The old identifier parser and display name lookup */
+static GkeyCode OldIdentifierToCode(const char* keyIdentifier) {
+    size_t len = strlen(keyIdentifier) + 1;
+    char* str = (char*)malloc(len);
+    memcpy(str, keyIdentifier, len);
+
+    char* cntx = NULL;
+    char* device = strtok_r(str, "-", &cntx);
+    char* gkey = strtok_r(NULL, "-", &cntx);
+    char* mkey = strtok_r(NULL, "-", &cntx);
+
+    GkeyCode code = { 0 };
+    if (device)
+        code.mouse = (strcmp(device, "mouse") == 0) ? 1 : 0;
+    if (gkey)
+        code.keyIdx = atoi(gkey + 1);
+    if (mkey)
+        code.mState = atoi(mkey + 1);
+
+    free(str);
+    return code;
+}
+
+static const char* OldDisplayKeyText(const char* keyIdentifier) {
+    GkeyCode code = OldIdentifierToCode(keyIdentifier);
+
+    wchar_t* text = NULL;
+    if (code.mouse)
+        text = LogiGkeyGetMouseButtonString(code.keyIdx);
+    else
+        text = LogiGkeyGetKeyboardGkeyString(code.keyIdx, code.mState);
+
+    /* Stands in for wcharToUtf8, which sized and allocated a new result on every call */
+    static char* result = NULL;
+    if (result)
+        free(result);
+    size_t len = wcslen(text);
+    result = (char*)malloc(len * 4 + 1);
+    char* out = result;
+    for (size_t i = 0; i < len; i++) {
+        unsigned int c = (unsigned int)text[i];
+        if (c < 0x80) {
+            *out++ = (char)c;
+        } else if (c < 0x800) {
+            *out++ = (char)(0xC0 | (c >> 6));
+            *out++ = (char)(0x80 | (c & 0x3F));
+        } else {
+            *out++ = (char)(0xE0 | (c >> 12));
+            *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (c & 0x3F));
+        }
+    }
+    *out = '\0';
+    return result;
+}
+
+/* Returns the number of allocations made by the callback */
+static unsigned long long BenchCallback(const char* name, void (*callback)(GkeyCode)) {
+    LatencySamples samples(EVENTS);
+    const unsigned long long allocations = AllocCount();
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < EVENTS; i++) {
+        const GkeyCode code = HostKey(1 + (i / 2) % LOGITECH_MAX_GKEYS, 1 + (i / 58) % LOGITECH_MAX_M_STATES, !(i & 1));
+        const uint64_t t0 = HostTimestamp();
+        callback(code);
+        samples.add(HostTimestamp() - t0);
+    }
+    const uint64_t wallTime = HostTimestamp() - start;
+    const unsigned long long allocated = AllocCount() - allocations;
+    Report(name, samples, wallTime, allocated);
+    return allocated;
+}
+
+static void BenchLookup(const char* name, const char* (*lookup)(const char*), const std::vector<std::string>& identifiers,
+                        bool expectNoAllocations) {
+    LatencySamples samples(LOOKUPS);
+    const unsigned long long allocations = AllocCount();
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        const char* identifier = identifiers[i % identifiers.size()].c_str();
+        const uint64_t t0 = HostTimestamp();
+        const char* result = lookup(identifier);
+        samples.add(HostTimestamp() - t0);
+        if (!result || !*result) {
+            HostCheck(false, "lookups return a name");
+            break;
+        }
+    }
+    const uint64_t wallTime = HostTimestamp() - start;
+    const unsigned long long allocated = AllocCount() - allocations;
+    Report(name, samples, wallTime, allocated);
+    if (expectNoAllocations && AllocCountSupported())
+        HostCheck(allocated == 0, "identifier lookups don't allocate");
+}
+
+int main() {
+    std::vector<std::string> identifiers;
+    for (unsigned int gkey = 1; gkey <= LOGITECH_MAX_GKEYS; gkey++) {
+        for (unsigned int mode = 1; mode <= LOGITECH_MAX_M_STATES; mode++)
+            identifiers.push_back("keybd-g" + std::to_string(gkey) + "-m" + std::to_string(mode));
+    }
+    for (unsigned int button = 1; button <= LOGITECH_MAX_MOUSE_BUTTONS; button++)
+        identifiers.push_back("mouse-g" + std::to_string(button) + "-m0");
+
+    if (!HostStart("queue_capacity = 0\n"))
+        return HostExitCode();
+
+    BenchCallback("old SDK callback (snprintf)", OldSDKCallback);
+    HostCheck(oldNotifications.load() == EVENTS, "the old callback notifies every event");
+
+    std::vector<std::string> tapHoldIds;
+    for (size_t i = 0; i < identifiers.size(); i++)
+        tapHoldIds.push_back(identifiers[i] + (i & 1 ? "-hold" : "-tap"));
+
+    /* Warm up the display name cache before measuring steady state allocations */
+    for (size_t i = 0; i < identifiers.size(); i++) {
+        ts3plugin_displayKeyText(identifiers[i].c_str());
+        ts3plugin_displayKeyText(tapHoldIds[i].c_str());
+    }
+
+    const unsigned long long before = hostNotifications.load();
+    const unsigned long long allocated = BenchCallback("new SDK callback (precomputed)", MockGkeyEvent);
+    HostCheck(hostNotifications.load() - before == EVENTS, "the new callback notifies every event");
+    if (AllocCountSupported())
+        HostCheck(allocated == 0, "the SDK callback doesn't allocate");
+
+    BenchLookup("old ts3plugin_displayKeyText (malloc + strtok)", OldDisplayKeyText, identifiers, false);
+    BenchLookup("new ts3plugin_displayKeyText", ts3plugin_displayKeyText, identifiers, true);
+    BenchLookup("new ts3plugin_displayKeyText, tap_hold", ts3plugin_displayKeyText, tapHoldIds, true);
+    BenchLookup("new ts3plugin_keyDeviceName", ts3plugin_keyDeviceName, identifiers, true);
+
+    /* Every key has exactly one identifier, non-canonical spellings are not ours */
+    HostCheck(strcmp(ts3plugin_displayKeyText("keybd-g1-m1"), "G1/M1 \xE2\x8C\x98") == 0, "canonical identifiers are parsed");
+    HostCheck(strcmp(ts3plugin_displayKeyText("keybd-g1-m1-tap"), "G1/M1 \xE2\x8C\x98-tap") == 0 &&
+        strcmp(ts3plugin_displayKeyText("mouse-g4-m0-hold"), "Mouse Button 4-hold") == 0, "tap_hold identifiers are named after their key");
+    const char* aliases[] = { "keybd-g01-m1", "keybd-g1-m01", "mouse-g06-m0", "keybd-g+1-m1", "keybd-g1-m1-" };
+    for (size_t i = 0; i < sizeof(aliases) / sizeof(aliases[0]); i++)
+        HostCheck(strcmp(ts3plugin_displayKeyText(aliases[i]), aliases[i]) == 0, "non-canonical identifiers are rejected");
+
+    HostStop();
+    return HostExitCode();
+}
@@ -0,0 +1,105 @@
+/*
+* Latency of the plugin's entry points as seen from the client and the G-key SDK: the SDK callback with and
+* without the dispatcher thread, the identifier lookups behind ts3plugin_keyDeviceName and the display names
+* behind ts3plugin_displayKeyText.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ts3_functions.h"
+#include "plugin.h"
+#include "host.h"
+
+#define EVENTS 200000
+#define LOOKUPS 200000
+
+/* Presses and releases every G-key in turn, timing each call into the SDK callback */
+static void BenchCallback(const char* name, bool waitForDispatch) {
+    LatencySamples samples(EVENTS);
+    const unsigned long long before = hostNotifications.load();
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < EVENTS; i++) {
+        const GkeyCode code = HostKey(1 + (i / 2) % LOGITECH_MAX_GKEYS, 1, !(i & 1));
+        const uint64_t t0 = HostTimestamp();
+        MockGkeyEvent(code);
+        samples.add(HostTimestamp() - t0);
+
+        /* Don't let the queue overflow, that would only measure dropped events */
+        if (waitForDispatch && (i & 63) == 63)
+            HostWaitFor(hostNotifications, before + i + 1, 5000);
+    }
+    HostCheck(HostWaitFor(hostNotifications, before + EVENTS, 5000), "every key event is notified");
+    samples.report(name, HostTimestamp() - start);
+}
+
+/* Time from the SDK callback until notifyKeyEvent is called on the dispatcher thread */
+static std::atomic<uint64_t> notifiedAt(0);
+
+static void RecordNotify(const char* keyIdentifier, bool down) {
+    notifiedAt.store(HostTimestamp(), std::memory_order_release);
+}
+
+static void BenchDispatchLatency(const char* name) {
+    const unsigned int events = EVENTS / 10;
+    LatencySamples samples(events);
+    HostSetNotifyFunc(RecordNotify);
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < events; i++) {
+        const unsigned long long before = hostNotifications.load();
+        const uint64_t t0 = HostTimestamp();
+        MockGkeyKey(1 + (i / 2) % LOGITECH_MAX_GKEYS, 1, !(i & 1));
+        if (!HostWaitFor(hostNotifications, before + 1, 5000))
+            break;
+        samples.add(notifiedAt.load(std::memory_order_acquire) - t0);
+    }
+    HostSetNotifyFunc(NULL);
+    HostCheck(samples.count() == events, "every key event reaches the dispatcher");
+    samples.report(name, HostTimestamp() - start);
+}
+
+static void BenchLookup(const char* name, const char* (*lookup)(const char*), const std::vector<std::string>& identifiers) {
+    LatencySamples samples(LOOKUPS);
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        const char* identifier = identifiers[i % identifiers.size()].c_str();
+        const uint64_t t0 = HostTimestamp();
+        const char* result = lookup(identifier);
+        samples.add(HostTimestamp() - t0);
+        if (!result || !*result) {
+            HostCheck(false, "lookups return a name");
+            break;
+        }
+    }
+    samples.report(name, HostTimestamp() - start);
+}
+
+int main() {
+    std::vector<std::string> identifiers;
+    for (unsigned int gkey = 1; gkey <= LOGITECH_MAX_GKEYS; gkey++) {
+        for (unsigned int mode = 1; mode <= LOGITECH_MAX_M_STATES; mode++)
+            identifiers.push_back("keybd-g" + std::to_string(gkey) + "-m" + std::to_string(mode));
+    }
+    for (unsigned int button = 1; button <= LOGITECH_MAX_MOUSE_BUTTONS; button++)
+        identifiers.push_back("mouse-g" + std::to_string(button) + "-m0");
+
+    if (!HostStart("queue_capacity = 0\n"))
+        return HostExitCode();
+    BenchCallback("SDK callback, direct dispatch", false);
+    BenchLookup("ts3plugin_keyDeviceName", ts3plugin_keyDeviceName, identifiers);
+
+    const unsigned int fetches = MockGkeyNameFetches();
+    BenchLookup("ts3plugin_displayKeyText", ts3plugin_displayKeyText, identifiers);
+    HostCheck(MockGkeyNameFetches() - fetches == identifiers.size(), "every display name is fetched from the SDK once");
+    HostCheck(strcmp(ts3plugin_displayKeyText("keybd-g1-m2"), "G1/M2 \xE2\x8C\x98") == 0, "display names are converted to UTF-8");
+    HostCheck(strcmp(ts3plugin_keyDeviceName("mouse-g6-m0"), "Logitech Mouse") == 0, "mouse buttons belong to the mouse");
+    HostStop();
+
+    if (!HostStart("queue_capacity = 4096\n"))
+        return HostExitCode();
+    BenchCallback("SDK callback, dispatcher thread", true);
+    BenchDispatchLatency("SDK callback to notifyKeyEvent");
+    HostStop();
+
+    return HostExitCode();
+}
@@ -0,0 +1,115 @@
+/*
+* Latency and cost of the poll backend. Presses are made through the mock SDK's pressed state after the poller
+* backed off to its idle interval, releases while it polls quickly for the held key. The wakeups and the time
+* spent polling come from the plugin's own statistics, idle and while a key is held.
+*/
+#include <stdio.h>
+#include <string>
+#include <chrono>
+#include <thread>
+#include "host.h"
+
+#define PRESSES 40
+#define MS 1000000ULL
+
+struct PollingStats {
+    unsigned long long wakeups, edges, pollTime, maxDetectLatency;  /* Times in microseconds */
+};
+
+static bool ReadPollingStats(PollingStats* stats) {
+    const std::string line = HostCommand("stats", "Polling:");
+    return sscanf(line.c_str(), "Polling: %llu wakeups, %llu edges, %lluus spent polling, worst-case detection latency %lluus",
+        &stats->wakeups, &stats->edges, &stats->pollTime, &stats->maxDetectLatency) == 4;
+}
+
+static void Sleep(unsigned int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static std::atomic<uint64_t> notifiedAt(0);
+
+static void RecordNotify(const char* keyIdentifier, bool down) {
+    notifiedAt.store(HostTimestamp(), std::memory_order_release);
+}
+
+/* Counts the poller's wakeups over a period, returns them per second */
+static double WakeupRate(const char* name, unsigned int ms) {
+    HostCommand("reset", NULL);
+    Sleep(ms);
+    PollingStats stats;
+    if (!ReadPollingStats(&stats)) {
+        HostCheck(false, "the polling statistics are printed");
+        return 0;
+    }
+    const double rate = stats.wakeups * 1000.0 / ms;
+    printf("%-40s %8.1f wakeups/s   %6lluns polling per wakeup\n", name, rate,
+        stats.wakeups ? stats.pollTime * 1000 / stats.wakeups : 0ULL);
+    return rate;
+}
+
+/* Presses and releases a key, returns whether the plugin notified each edge once */
+static bool Press(LatencySamples& samples, bool down) {
+    const unsigned long long before = hostNotifications.load();
+    const uint64_t t0 = HostTimestamp();
+    MockGkeyKey(1, 1, down);
+    if (!HostWaitFor(hostNotifications, before + 1, 5000))
+        return false;
+    samples.add(notifiedAt.load(std::memory_order_acquire) - t0);
+    return true;
+}
+
+int main() {
+    /* A session with the SDK callback first, its callback must not keep delivering events once polling */
+    if (!HostStart("queue_capacity = 0\n"))
+        return HostExitCode();
+    MockGkeyKey(1, 1, true);
+    MockGkeyKey(1, 1, false);
+    HostStop();
+
+    if (!HostStart("queue_capacity = 0\nbackend = poll\npoll_interval_ms = 2\npoll_idle_interval_ms = 50\n"))
+        return HostExitCode();
+    HostSetNotifyFunc(RecordNotify);
+
+    /* Let the poller back off before counting */
+    Sleep(200);
+    const double idle = WakeupRate("idle", 1000);
+    LatencySamples held;
+    HostCheck(Press(held, true), "the press is notified");
+    const double active = WakeupRate("key held", 500);
+    HostCheck(Press(held, false), "the release is notified");
+    HostCheck(idle <= 30, "the poller backs off while no key is held");
+    HostCheck(active >= 5 * idle, "the poller polls quickly while a key is held");
+
+    /* Press at varying points of the idle interval, release while the key is polled quickly */
+    HostCommand("reset", NULL);
+    LatencySamples presses(PRESSES), releases(PRESSES);
+    const unsigned long long before = hostNotifications.load();
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < PRESSES; i++) {
+        Sleep(120 + i * 7 % 50);
+        if (!Press(presses, true))
+            break;
+        Sleep(5);
+        if (!Press(releases, false))
+            break;
+    }
+    const uint64_t wallTime = HostTimestamp() - start;
+    Sleep(100);
+    HostSetNotifyFunc(NULL);
+
+    HostCheck(hostNotifications.load() - before == 2 * PRESSES, "every edge is notified once");
+    presses.report("press to notifyKeyEvent, idle", wallTime);
+    releases.report("release to notifyKeyEvent, held", wallTime);
+
+    PollingStats stats;
+    if (ReadPollingStats(&stats)) {
+        HostCheck(stats.edges == 2 * PRESSES, "the poller detects every edge");
+        /* Notifying happens after detection, allow for the thread being scheduled out in between */
+        HostCheck(presses.percentile(1.0) <= stats.maxDetectLatency * 1000 + 5 * MS,
+            "the measured worst-case detection latency bounds the press latency");
+    } else {
+        HostCheck(false, "the polling statistics are printed");
+    }
+    HostStop();
+    return HostExitCode();
+}
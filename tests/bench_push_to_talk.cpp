@@ -0,0 +1,105 @@
+/*
+* Press-to-unmute latency of push_to_talk keys against binding the key as a TeamSpeak hotkey. For the hotkey
+* path the host stands in for the client: it resolves the notified identifier in a string-keyed hotkey table
+* and only then activates the input. Also checks that the microphone can't be left live.
+*/
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include "host.h"
+
+#define PRESSES 20000
+
+static std::atomic<uint64_t> unmutedAt(0);
+static std::atomic<unsigned long long> unmutes(0);
+
+static void RecordInput(uint64 connection, int deactivated) {
+    if (deactivated == INPUT_ACTIVE) {
+        unmutedAt.store(HostTimestamp(), std::memory_order_relaxed);
+        unmutes.fetch_add(1, std::memory_order_release);
+    }
+}
+
+/* The client's hotkey lookup, filled with a typical number of bindings */
+static std::unordered_map<std::string, int> clientHotkeys;
+
+static void ClientHotkey(const char* keyIdentifier, bool down) {
+    std::unordered_map<std::string, int>::const_iterator it = clientHotkeys.find(std::string("gkey") + keyIdentifier);
+    if (it != clientHotkeys.end() && it->second == 1)
+        RecordInput(1, down ? INPUT_ACTIVE : INPUT_DEACTIVATED);
+}
+
+static void BenchUnmute(const char* name, const char* settings, bool hotkey) {
+    if (!HostStart(settings))
+        return;
+    if (hotkey)
+        HostSetNotifyFunc(ClientHotkey);
+    else
+        HostSetInputFunc(RecordInput);
+
+    LatencySamples samples(PRESSES);
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < PRESSES; i++) {
+        const unsigned long long before = unmutes.load();
+        const uint64_t t0 = HostTimestamp();
+        MockGkeyKey(1, 1, true);
+        if (!HostWaitFor(unmutes, before + 1, 5000))
+            break;
+        samples.add(unmutedAt.load(std::memory_order_relaxed) - t0);
+        MockGkeyKey(1, 1, false);
+    }
+    const uint64_t wallTime = HostTimestamp() - start;
+    HostSetNotifyFunc(NULL);
+    HostSetInputFunc(NULL);
+    HostStop();
+
+    HostCheck(samples.count() == PRESSES, "every press unmutes");
+    samples.report(name, wallTime);
+}
+
+static void CheckConnections() {
+    if (!HostStart("push_to_talk = keybd-g1-m1\n"))
+        return;
+    HostCheck(hostInputDeactivated[1].load() == INPUT_DEACTIVATED, "the microphone starts out deactivated");
+
+    const unsigned long long init = hostInputChanges.load();
+    MockGkeyKey(1, 1, true);
+    HostWaitFor(hostInputChanges, init + 1, 5000);
+    HostCheck(hostInputDeactivated[1].load() == INPUT_ACTIVE, "pressing the key activates the microphone");
+
+    /* Switching tabs while talking leaves the new tab muted and the old one live until the key is released */
+    HostSetCurrentConnection(2);
+    HostCheck(hostInputDeactivated[2].load() == INPUT_DEACTIVATED, "a new current tab is deactivated");
+    HostSetCurrentConnection(1);
+    HostCheck(hostInputDeactivated[1].load() == INPUT_ACTIVE, "the tab the key is held on stays active");
+    HostSetCurrentConnection(2);
+
+    const unsigned long long changes = hostInputChanges.load();
+    MockGkeyKey(1, 1, false);
+    HostWaitFor(hostInputChanges, changes + 1, 5000);
+    HostCheck(hostInputDeactivated[1].load() == INPUT_DEACTIVATED, "releasing the key deactivates the tab it was pressed on");
+    HostCheck(hostInputDeactivated[2].load() == INPUT_DEACTIVATED, "the current tab stays deactivated");
+
+    HostSetCurrentConnection(1);
+    HostStop();
+
+    /* Without push-to-talk keys the input state is left alone */
+    if (HostStart("toggle_input = keybd-g1-m1\n")) {
+        HostCheck(hostInputDeactivated[1].load() == -1, "the input state is left alone without push_to_talk");
+        HostStop();
+    }
+}
+
+int main() {
+    for (unsigned int gkey = 1; gkey <= LOGITECH_MAX_GKEYS; gkey++) {
+        for (unsigned int mode = 1; mode <= LOGITECH_MAX_M_STATES; mode++)
+            clientHotkeys["gkeykeybd-g" + std::to_string(gkey) + "-m" + std::to_string(mode)] = gkey;
+    }
+
+    CheckConnections();
+    BenchUnmute("hotkey via notifyKeyEvent, direct", "queue_capacity = 0\n", true);
+    BenchUnmute("push_to_talk, direct", "queue_capacity = 0\npush_to_talk = keybd-g1-m1\n", false);
+    BenchUnmute("hotkey via notifyKeyEvent, dispatcher", "", true);
+    BenchUnmute("push_to_talk, dispatcher", "push_to_talk = keybd-g1-m1\n", false);
+    return HostExitCode();
+}
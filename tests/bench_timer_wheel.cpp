@@ -0,0 +1,72 @@
+/*
+* Every key slot as a repeating timer, the worst case of repeat keys, advanced in real time the way the
+* dispatcher does: sleep until the wake time the wheel returns, then advance to the current time. Reports the
+* jitter and the time per expiry from the wheel's own statistics.
+*/
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include "timer_wheel.h"
+
+#define RUN_MS 2000
+#define MS 1000000ULL
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static uint64_t intervals[GKEY_SLOT_COUNT];
+static uint64_t advancedTo = 0;
+static unsigned long long early = 0;
+
+/* Repeats the timer from its deadline like repeat keys do */
+static void Expire(unsigned int slot, uint64_t deadline) {
+    if (advancedTo < deadline)
+        early++;
+    TimerWheelSchedule(slot, advancedTo, deadline + intervals[slot]);
+}
+
+int main() {
+    const uint64_t start = GkeyTimestamp();
+    TimerWheelInit(start);
+    TimerWheelResetStats();
+
+    /* Intervals of 20 to 83ms with the first deadlines spread over the first interval */
+    double expected = 0;
+    for (unsigned int slot = 0; slot < GKEY_SLOT_COUNT; slot++) {
+        intervals[slot] = (20 + slot % 64) * MS;
+        const uint64_t first = start + intervals[slot] * (slot % 17) / 17;
+        TimerWheelSchedule(slot, start, first);
+        expected += (double)(start + RUN_MS * MS - first) / intervals[slot];
+    }
+
+    unsigned long long advances = 0;
+    const uint64_t end = start + RUN_MS * MS;
+    for (uint64_t now = start; now < end; now = GkeyTimestamp()) {
+        advancedTo = now;
+        const uint64_t next = TimerWheelAdvance(now, Expire);
+        advances++;
+        if (next > now)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(next - now));
+    }
+
+    TimerWheelStats stats;
+    TimerWheelGetStats(&stats);
+    printf("%u repeating timers for %ums: %llu expiries (%.0f/s) in %llu advances\n", GKEY_SLOT_COUNT, RUN_MS, stats.fired,
+        stats.fired * 1000.0 / RUN_MS, advances);
+    printf("    jitter avg %lluns max %lluns, %.1fns advancing per expiry\n",
+        stats.fired ? (unsigned long long)(stats.totalJitter / stats.fired) : 0ULL, (unsigned long long)stats.maxJitter,
+        stats.fired ? (double)stats.advanceTime / stats.fired : 0.0);
+
+    Check(stats.maxActive == GKEY_SLOT_COUNT, "every slot has a pending timer");
+    Check(early == 0, "timers never fire before their deadline");
+    Check(stats.fired >= 0.9 * expected && stats.fired <= expected + GKEY_SLOT_COUNT, "timers keep firing at their interval");
+    /* Generous, the jitter is mostly how late the sleep returns on a busy machine */
+    Check(stats.fired && stats.totalJitter / stats.fired < 10 * MS, "timers fire close to their deadline");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <dirent.h>
+#include <unistd.h>
+#include "teamspeak/public_errors.h"
+#include "ts3_functions.h"
+#include "plugin.h"
+#include "host.h"
+
+std::atomic<unsigned long long> hostNotifications(0);
+std::atomic<unsigned long long> hostInvalidNotifications(0);
+std::atomic<unsigned long long> hostInputChanges(0);
+std::atomic<int> hostInputDeactivated[HOST_CONNECTIONS];
+
+static char configDir[256];
+static char configFile[512];
+static std::atomic<bool> loaded(false);
+static std::atomic<uint64> currentConnection(1);
+static std::atomic<HostNotifyFunc> notifyFunc(NULL);
+static std::atomic<HostInputFunc> inputFunc(NULL);
+static const char* commandFilter = NULL;
+static std::string commandLine;
+static bool usesSdk = true;
+static unsigned int failures = 0;
+
+static unsigned int HostLogMessage(const char* logMessage, enum LogLevel severity, const char* channel, uint64 logID) {
+    return ERROR_ok;
+}
+
+static void HostNotifyKeyEvent(const char* pluginID, const char* keyIdentifier, int up_down) {
+    if (!pluginID || !loaded.load(std::memory_order_acquire))
+        hostInvalidNotifications.fetch_add(1, std::memory_order_relaxed);
+    const HostNotifyFunc func = notifyFunc.load(std::memory_order_acquire);
+    if (func)
+        func(keyIdentifier, up_down == 0);
+    hostNotifications.fetch_add(1, std::memory_order_release);
+}
+
+static unsigned int HostGetClientSelfVariableAsInt(uint64 serverConnectionHandlerID, size_t flag, int* result) {
+    if (serverConnectionHandlerID >= HOST_CONNECTIONS || flag != CLIENT_INPUT_DEACTIVATED)
+        return ERROR_undefined;
+    *result = hostInputDeactivated[serverConnectionHandlerID].load() == INPUT_DEACTIVATED ? INPUT_DEACTIVATED : INPUT_ACTIVE;
+    return ERROR_ok;
+}
+
+static unsigned int HostSetClientSelfVariableAsInt(uint64 serverConnectionHandlerID, size_t flag, int value) {
+    if (serverConnectionHandlerID >= HOST_CONNECTIONS || flag != CLIENT_INPUT_DEACTIVATED)
+        return ERROR_undefined;
+    hostInputDeactivated[serverConnectionHandlerID].store(value);
+    const HostInputFunc func = inputFunc.load(std::memory_order_acquire);
+    if (func)
+        func(serverConnectionHandlerID, value);
+    hostInputChanges.fetch_add(1, std::memory_order_release);
+    return ERROR_ok;
+}
+
+static unsigned int HostFlushClientSelfUpdates(uint64 serverConnectionHandlerID, const char* returnCode) {
+    return ERROR_ok;
+}
+
+static void HostPrintMessageToCurrentTab(const char* message) {
+    if (commandFilter && strncmp(message, commandFilter, strlen(commandFilter)) == 0) {
+        printf("  %s\n", message);
+        commandLine = message;
+    }
+}
+
+static void HostGetConfigPath(char* path, size_t maxLen) {
+    snprintf(path, maxLen, "%s/", configDir);
+}
+
+static uint64 HostGetCurrentServerConnectionHandlerID() {
+    return currentConnection.load();
+}
+
+static void RemoveConfigDir() {
+    if (!*configDir)
+        return;
+    DIR* dir = opendir(configDir);
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                unlink(HostConfigFile(entry->d_name));
+        }
+        closedir(dir);
+    }
+    rmdir(configDir);
+    *configDir = '\0';
+}
+
+bool HostInit(const char* settings) {
+    RemoveConfigDir();
+    snprintf(configDir, sizeof(configDir), "/tmp/gkey_host_XXXXXX");
+    if (!mkdtemp(configDir)) {
+        perror("mkdtemp");
+        HostCheck(false, "the config directory is created");
+        return false;
+    }
+
+    FILE* file = fopen(HostConfigFile("gkey_plugin.ini"), "w");
+    if (!file) {
+        HostCheck(false, "the settings are written");
+        return false;
+    }
+    fputs(settings, file);
+    fclose(file);
+    /* Only the evdev backend and replays run without the G-key SDK */
+    usesSdk = !strstr(settings, "evdev") && !strstr(settings, "replay_file");
+
+    for (unsigned int connection = 0; connection < HOST_CONNECTIONS; connection++)
+        hostInputDeactivated[connection].store(-1);
+
+    struct TS3Functions funcs;
+    memset(&funcs, 0, sizeof(funcs));
+    funcs.logMessage = HostLogMessage;
+    funcs.notifyKeyEvent = HostNotifyKeyEvent;
+    funcs.getClientSelfVariableAsInt = HostGetClientSelfVariableAsInt;
+    funcs.setClientSelfVariableAsInt = HostSetClientSelfVariableAsInt;
+    funcs.flushClientSelfUpdates = HostFlushClientSelfUpdates;
+    funcs.printMessageToCurrentTab = HostPrintMessageToCurrentTab;
+    funcs.getConfigPath = HostGetConfigPath;
+    funcs.getCurrentServerConnectionHandlerID = HostGetCurrentServerConnectionHandlerID;
+    ts3plugin_setFunctionPointers(funcs);
+
+    loaded.store(true, std::memory_order_release);
+    if (ts3plugin_init() != 0) {
+        loaded.store(false);
+        HostCheck(false, "the plugin loads");
+        return false;
+    }
+    return true;
+}
+
+bool HostRegister() {
+    ts3plugin_registerPluginID("gkey_plugin_host");
+    if (usesSdk && !MockGkeyWaitReady(5000)) {
+        HostCheck(false, "the plugin initializes the G-key SDK");
+        return false;
+    }
+    return true;
+}
+
+bool HostStart(const char* settings) {
+    return HostInit(settings) && HostRegister();
+}
+
+void HostStop() {
+    ts3plugin_shutdown();
+    loaded.store(false, std::memory_order_release);
+    RemoveConfigDir();
+}
+
+const char* HostConfigFile(const char* name) {
+    snprintf(configFile, sizeof(configFile), "%s/%s", configDir, name);
+    return configFile;
+}
+
+void HostSetCurrentConnection(uint64 connection) {
+    currentConnection.store(connection);
+    ts3plugin_currentServerConnectionChanged(connection);
+}
+
+void HostSetNotifyFunc(HostNotifyFunc func) {
+    notifyFunc.store(func, std::memory_order_release);
+}
+
+void HostSetInputFunc(HostInputFunc func) {
+    inputFunc.store(func, std::memory_order_release);
+}
+
+bool HostWaitFor(const std::atomic<unsigned long long>& counter, unsigned long long value, unsigned int timeoutMs) {
+    const uint64_t deadline = HostTimestamp() + timeoutMs * 1000000ULL;
+    while (counter.load(std::memory_order_acquire) < value) {
+        if (HostTimestamp() > deadline)
+            return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+std::string HostCommand(const char* command, const char* filter) {
+    commandFilter = filter;
+    commandLine.clear();
+    ts3plugin_processCommand(currentConnection.load(), command);
+    commandFilter = NULL;
+    return commandLine;
+}
+
+void HostCheck(bool condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+int HostExitCode() {
+    HostCheck(hostInvalidNotifications.load() == 0, "notifyKeyEvent is only called with a plugin ID while loaded");
+    return failures ? 1 : 0;
+}
+
+uint64_t LatencySamples::percentile(double fraction) {
+    if (samples.empty())
+        return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = (size_t)(fraction * (double)samples.size());
+    return samples[index < samples.size() ? index : samples.size() - 1];
+}
+
+void LatencySamples::report(const char* name, uint64_t wallTime) {
+    const double seconds = wallTime / 1e9;
+    printf("%-40s %9zu events %12.0f/s   p50 %7lluns   p99 %7lluns   p999 %8lluns   max %9lluns\n", name, samples.size(),
+        seconds > 0 ? samples.size() / seconds : 0.0, (unsigned long long)percentile(0.5), (unsigned long long)percentile(0.99),
+        (unsigned long long)percentile(0.999), (unsigned long long)percentile(1.0));
+}
+
+uint64_t HostTimestamp() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
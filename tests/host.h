@@ -0,0 +1,94 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "teamspeak/public_definitions.h"
+#include "mock_gkey.h"
+
+/*
+* Headless stand-in for the TeamSpeak client. It loads the plugin through its ts3plugin_* exports with a mock
+* TS3Functions table, and writes the given settings to gkey_plugin.ini in a temporary config directory.
+*/
+#define HOST_CONNECTIONS 8
+
+/* Calls ts3plugin_init, returns false and records a failure if it failed */
+bool HostInit(const char* settings);
+
+/*
+* Registers the plugin ID and waits for the mock SDK to be initialized unless the settings select evdev or a replay,
+* returns false and records a failure if it wasn't
+*/
+bool HostRegister();
+
+/* HostInit followed by HostRegister */
+bool HostStart(const char* settings);
+
+/* Calls ts3plugin_shutdown and removes the config directory */
+void HostStop();
+
+/* Path of a file inside the config directory, valid until the next HostInit */
+const char* HostConfigFile(const char* name);
+
+/* Switches the current server connection and tells the plugin */
+void HostSetCurrentConnection(uint64 connection);
+
+/* Called from the mock notifyKeyEvent and setClientSelfVariableAsInt on the plugin's threads */
+typedef void (*HostNotifyFunc)(const char* keyIdentifier, bool down);
+typedef void (*HostInputFunc)(uint64 connection, int deactivated);
+void HostSetNotifyFunc(HostNotifyFunc func);
+void HostSetInputFunc(HostInputFunc func);
+
+extern std::atomic<unsigned long long> hostNotifications;
+extern std::atomic<unsigned long long> hostInvalidNotifications;  /* Without a plugin ID or while the plugin was not loaded */
+extern std::atomic<unsigned long long> hostInputChanges;
+extern std::atomic<int> hostInputDeactivated[HOST_CONNECTIONS];   /* -1 until the plugin sets it */
+
+/* Waits until the counter reaches the given value, returns false on timeout */
+bool HostWaitFor(const std::atomic<unsigned long long>& counter, unsigned long long value, unsigned int timeoutMs);
+
+/*
+* Runs a console command, lines the plugin prints that start with the filter are written to stdout.
+* Returns the last of them so tests can parse the statistics.
+*/
+std::string HostCommand(const char* command, const char* filter);
+
+static inline GkeyCode HostKey(unsigned int keyIdx, unsigned int mState, bool down) {
+    GkeyCode code = { 0 };
+    code.keyIdx = keyIdx;
+    code.mState = mState;
+    code.keyDown = down ? 1 : 0;
+    return code;
+}
+
+/* Records a failure that is printed to stderr unless the condition holds */
+void HostCheck(bool condition, const char* what);
+
+/* Checks that no key event was notified without a plugin ID or while unloaded, returns 1 if anything failed */
+int HostExitCode();
+
+/* Collects latency samples in nanoseconds and reports their percentiles */
+class LatencySamples {
+public:
+    explicit LatencySamples(size_t reserve = 0) { samples.reserve(reserve); }
+
+    void add(uint64_t nanoseconds) { samples.push_back(nanoseconds); }
+    void clear() { samples.clear(); }
+    size_t count() const { return samples.size(); }
+
+    /* Sorts the samples, the fraction is between 0 and 1 */
+    uint64_t percentile(double fraction);
+
+    /* Prints the count, the throughput over the given wall time and the p50/p99/p999/max latency */
+    void report(const char* name, uint64_t wallTime);
+
+private:
+    std::vector<uint64_t> samples;
+};
+
+/* Monotonic time in nanoseconds, the same clock as the plugin's GkeyTimestamp */
+uint64_t HostTimestamp();
+
+#endif
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "mock_gkey.h"
+
+#define MOCK_NAME_SIZE 32
+
+static std::once_flag namesOnce;
+static std::mutex mockMutex;
+static std::condition_variable mockCond;
+static bool mockInitialized = false;
+static std::atomic<bool> mockAvailable(true);
+static std::atomic<logiGkeyCB> mockCallback(NULL);
+static std::atomic<void*> mockContext(NULL);
+static std::atomic<unsigned int> initCalls(0), nameFetches(0);
+
+static std::atomic<bool> keyboardPressed[LOGITECH_MAX_GKEYS + 1][LOGITECH_MAX_M_STATES + 1];
+static std::atomic<bool> mousePressed[LOGITECH_MAX_MOUSE_BUTTONS + 1];
+static wchar_t keyboardNames[LOGITECH_MAX_GKEYS + 1][LOGITECH_MAX_M_STATES + 1][MOCK_NAME_SIZE];
+static wchar_t mouseNames[LOGITECH_MAX_MOUSE_BUTTONS + 1][MOCK_NAME_SIZE];
+
+bool LogiGkeyInit(logiGkeyCBContext* gkeyCBContext) {
+    initCalls.fetch_add(1);
+    if (!mockAvailable.load())
+        return false;
+
+    /* Keyboard names end in a non-ASCII character so the plugin's UTF-8 conversion is exercised */
+    std::call_once(namesOnce, [] {
+        for (int gkey = 1; gkey <= LOGITECH_MAX_GKEYS; gkey++) {
+            for (int mode = 1; mode <= LOGITECH_MAX_M_STATES; mode++)
+                swprintf(keyboardNames[gkey][mode], MOCK_NAME_SIZE, L"G%d/M%d \u2318", gkey, mode);
+        }
+        for (int button = 1; button <= LOGITECH_MAX_MOUSE_BUTTONS; button++)
+            swprintf(mouseNames[button], MOCK_NAME_SIZE, L"Mouse Button %d", button);
+    });
+
+    /* Without a context the SDK only tracks the pressed state, a callback from an earlier init must not be kept */
+    mockContext.store(gkeyCBContext ? gkeyCBContext->gkeyContext : NULL);
+    mockCallback.store(gkeyCBContext ? gkeyCBContext->gkeyCallBack : NULL);
+
+    std::lock_guard<std::mutex> lock(mockMutex);
+    mockInitialized = true;
+    mockCond.notify_all();
+    return true;
+}
+
+bool LogiGkeyIsMouseButtonPressed(const int buttonNumber) {
+    if (buttonNumber < 1 || buttonNumber > LOGITECH_MAX_MOUSE_BUTTONS)
+        return false;
+    return mousePressed[buttonNumber].load(std::memory_order_relaxed);
+}
+
+wchar_t* LogiGkeyGetMouseButtonString(const int buttonNumber) {
+    nameFetches.fetch_add(1);
+    if (buttonNumber < 1 || buttonNumber > LOGITECH_MAX_MOUSE_BUTTONS)
+        return NULL;
+    return mouseNames[buttonNumber];
+}
+
+bool LogiGkeyIsKeyboardGkeyPressed(const int gkeyNumber, const int modeNumber) {
+    if (gkeyNumber < 1 || gkeyNumber > LOGITECH_MAX_GKEYS || modeNumber < 1 || modeNumber > LOGITECH_MAX_M_STATES)
+        return false;
+    return keyboardPressed[gkeyNumber][modeNumber].load(std::memory_order_relaxed);
+}
+
+wchar_t* LogiGkeyGetKeyboardGkeyString(const int gkeyNumber, const int modeNumber) {
+    nameFetches.fetch_add(1);
+    if (gkeyNumber < 1 || gkeyNumber > LOGITECH_MAX_GKEYS || modeNumber < 1 || modeNumber > LOGITECH_MAX_M_STATES)
+        return NULL;
+    return keyboardNames[gkeyNumber][modeNumber];
+}
+
+void LogiGkeyShutdown() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    mockInitialized = false;
+}
+
+void MockGkeySetAvailable(bool available) {
+    mockAvailable.store(available);
+}
+
+bool MockGkeyWaitReady(unsigned int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mockMutex);
+    return mockCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [] { return mockInitialized; });
+}
+
+void MockGkeyEvent(GkeyCode code) {
+    if (code.mouse) {
+        if (code.keyIdx >= 1 && code.keyIdx <= LOGITECH_MAX_MOUSE_BUTTONS)
+            mousePressed[code.keyIdx].store(code.keyDown != 0, std::memory_order_relaxed);
+    } else if (code.keyIdx >= 1 && code.keyIdx <= LOGITECH_MAX_GKEYS && code.mState >= 1) {
+        keyboardPressed[code.keyIdx][code.mState].store(code.keyDown != 0, std::memory_order_relaxed);
+    }
+
+    const logiGkeyCB callback = mockCallback.load(std::memory_order_acquire);
+    if (callback)
+        callback(code, NULL, mockContext.load(std::memory_order_relaxed));
+}
+
+void MockGkeyKey(unsigned int keyIdx, unsigned int mState, bool down) {
+    GkeyCode code = { 0 };
+    code.keyIdx = keyIdx;
+    code.mState = mState;
+    code.keyDown = down ? 1 : 0;
+    MockGkeyEvent(code);
+}
+
+unsigned int MockGkeyInitCalls() {
+    return initCalls.load();
+}
+
+unsigned int MockGkeyNameFetches() {
+    return nameFetches.load();
+}
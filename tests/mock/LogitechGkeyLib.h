@@ -0,0 +1,42 @@
+/*
+* Stand-in for the header of the Logitech G-key SDK with the same declarations, implemented by the mock
+* in LogitechGkeyLib.cpp. The tests drive it through the functions in mock_gkey.h.
+*/
+#ifndef LOGITECH_GKEY_LIB_H
+#define LOGITECH_GKEY_LIB_H
+
+#include <wchar.h>
+
+#if !defined(_WIN32) && !defined(__cdecl)
+#define __cdecl
+#endif
+
+#define LOGITECH_MAX_MOUSE_BUTTONS 20
+#define LOGITECH_MAX_GKEYS 29
+#define LOGITECH_MAX_M_STATES 3
+
+typedef struct {
+    unsigned int keyIdx : 8;      /* Index of the G-key or mouse button, for example 6 for G6 or Button 6 */
+    unsigned int keyDown : 1;     /* 1 is down, 0 is up */
+    unsigned int mState : 2;      /* 1, 2 or 3 for M1, M2 and M3 */
+    unsigned int mouse : 1;       /* Whether the event comes from a mouse */
+    unsigned int reserved1 : 4;
+    unsigned int reserved2 : 16;
+} GkeyCode;
+
+/* Called on the SDK's own thread for every key event */
+typedef void (__cdecl *logiGkeyCB)(GkeyCode gkeyCode, const wchar_t* gkeyOrButtonString, void* context);
+
+typedef struct {
+    logiGkeyCB gkeyCallBack;
+    void* gkeyContext;
+} logiGkeyCBContext;
+
+bool LogiGkeyInit(logiGkeyCBContext* gkeyCBContext);
+bool LogiGkeyIsMouseButtonPressed(const int buttonNumber);
+wchar_t* LogiGkeyGetMouseButtonString(const int buttonNumber);
+bool LogiGkeyIsKeyboardGkeyPressed(const int gkeyNumber, const int modeNumber);
+wchar_t* LogiGkeyGetKeyboardGkeyString(const int gkeyNumber, const int modeNumber);
+void LogiGkeyShutdown();
+
+#endif
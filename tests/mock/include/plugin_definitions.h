@@ -0,0 +1,26 @@
+/* Minimal stand-in for the TeamSpeak 3 plugin SDK, see teamspeak/public_definitions.h */
+#ifndef PLUGIN_DEFINITIONS_H
+#define PLUGIN_DEFINITIONS_H
+
+enum PluginConfigureOffer {
+    PLUGIN_OFFERS_NO_CONFIGURE = 0,
+    PLUGIN_OFFERS_CONFIGURE_NEW_THREAD,
+    PLUGIN_OFFERS_CONFIGURE_QT_THREAD,
+};
+
+enum PluginItemType {
+    PLUGIN_SERVER = 0,
+    PLUGIN_CHANNEL,
+    PLUGIN_CLIENT,
+};
+
+enum PluginMenuType {
+    PLUGIN_MENU_TYPE_GLOBAL = 0,
+    PLUGIN_MENU_TYPE_CHANNEL,
+    PLUGIN_MENU_TYPE_CLIENT,
+};
+
+struct PluginMenuItem;
+struct PluginHotkey;
+
+#endif
@@ -0,0 +1,14 @@
+/* Minimal stand-in for the TeamSpeak 3 plugin SDK, see teamspeak/public_definitions.h */
+#ifndef TEAMLOG_LOGTYPES_H
+#define TEAMLOG_LOGTYPES_H
+
+enum LogLevel {
+    LogLevel_CRITICAL = 0,
+    LogLevel_ERROR,
+    LogLevel_WARNING,
+    LogLevel_DEBUG,
+    LogLevel_INFO,
+    LogLevel_DEVEL,
+};
+
+#endif
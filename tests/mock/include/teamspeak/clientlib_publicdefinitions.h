@@ -0,0 +1,7 @@
+/* Minimal stand-in for the TeamSpeak 3 plugin SDK, see teamspeak/public_definitions.h */
+#ifndef CLIENTLIB_PUBLICDEFINITIONS_H
+#define CLIENTLIB_PUBLICDEFINITIONS_H
+
+#include "teamspeak/public_definitions.h"
+
+#endif
@@ -0,0 +1,42 @@
+/*
+* Minimal stand-in for the TeamSpeak 3 plugin SDK headers, declaring only what the plugin and the test host use.
+* Set TS3_PLUGIN_SDK_DIR to the include directory of the real SDK to build against it instead.
+*/
+#ifndef PUBLIC_DEFINITIONS_H
+#define PUBLIC_DEFINITIONS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "teamlog/logtypes.h"
+
+typedef uint64_t uint64;
+typedef unsigned short anyID;
+
+enum ConnectStatus {
+    STATUS_DISCONNECTED = 0,
+    STATUS_CONNECTING,
+    STATUS_CONNECTED,
+    STATUS_CONNECTION_ESTABLISHING,
+    STATUS_CONNECTION_ESTABLISHED,
+};
+
+enum InputDeactivationStatus {
+    INPUT_ACTIVE = 0,
+    INPUT_DEACTIVATED = 1,
+};
+
+enum ClientProperties {
+    CLIENT_UNIQUE_IDENTIFIER = 0,
+    CLIENT_NICKNAME,
+    CLIENT_VERSION,
+    CLIENT_PLATFORM,
+    CLIENT_FLAG_TALKING,
+    CLIENT_INPUT_MUTED,
+    CLIENT_OUTPUT_MUTED,
+    CLIENT_OUTPUTONLY_MUTED,
+    CLIENT_INPUT_HARDWARE,
+    CLIENT_OUTPUT_HARDWARE,
+    CLIENT_INPUT_DEACTIVATED,
+};
+
+#endif
@@ -0,0 +1,10 @@
+/* Minimal stand-in for the TeamSpeak 3 plugin SDK, see teamspeak/public_definitions.h */
+#ifndef PUBLIC_ERRORS_H
+#define PUBLIC_ERRORS_H
+
+enum Ts3ErrorType {
+    ERROR_ok = 0x0000,
+    ERROR_undefined = 0x0001,
+};
+
+#endif
@@ -0,0 +1,7 @@
+/* Minimal stand-in for the TeamSpeak 3 plugin SDK, see teamspeak/public_definitions.h */
+#ifndef PUBLIC_RARE_DEFINITIONS_H
+#define PUBLIC_RARE_DEFINITIONS_H
+
+#include "teamspeak/public_definitions.h"
+
+#endif
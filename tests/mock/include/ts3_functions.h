@@ -0,0 +1,23 @@
+/*
+* Minimal stand-in for the TeamSpeak 3 plugin SDK, see teamspeak/public_definitions.h. The real table has many
+* more functions, the test host only fills in the ones below by name so it builds against either header.
+*/
+#ifndef TS3_FUNCTIONS_H
+#define TS3_FUNCTIONS_H
+
+#include "teamspeak/clientlib_publicdefinitions.h"
+#include "teamspeak/public_definitions.h"
+#include "plugin_definitions.h"
+
+struct TS3Functions {
+    unsigned int (*logMessage)(const char* logMessage, enum LogLevel severity, const char* channel, uint64 logID);
+    unsigned int (*getClientSelfVariableAsInt)(uint64 serverConnectionHandlerID, size_t flag, int* result);
+    unsigned int (*setClientSelfVariableAsInt)(uint64 serverConnectionHandlerID, size_t flag, int value);
+    unsigned int (*flushClientSelfUpdates)(uint64 serverConnectionHandlerID, const char* returnCode);
+    void (*printMessageToCurrentTab)(const char* message);
+    void (*getConfigPath)(char* path, size_t maxLen);
+    uint64 (*getCurrentServerConnectionHandlerID)();
+    void (*notifyKeyEvent)(const char* pluginID, const char* keyIdentifier, int up_down);
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef MOCK_GKEY_H
+#define MOCK_GKEY_H
+
+#include "LogitechGkeyLib.h"
+
+/* Makes LogiGkeyInit fail while unavailable, like when the Logitech software is not running */
+void MockGkeySetAvailable(bool available);
+
+/* Waits until LogiGkeyInit succeeded, returns false on timeout */
+bool MockGkeyWaitReady(unsigned int timeoutMs);
+
+/*
+* Updates the pressed state of a key and passes the event to the registered callback, like the SDK does from its
+* own thread. Unlike the SDK it keeps calling the last callback after LogiGkeyShutdown until the next LogiGkeyInit
+* replaces or clears it, so tests can check that the plugin turns late callbacks away.
+*/
+void MockGkeyEvent(GkeyCode code);
+
+/* Convenience for MockGkeyEvent on a keyboard G-key of device 0 */
+void MockGkeyKey(unsigned int keyIdx, unsigned int mState, bool down);
+
+unsigned int MockGkeyInitCalls();
+unsigned int MockGkeyNameFetches();
+
+#endif
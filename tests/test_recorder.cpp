@@ -0,0 +1,73 @@
+/*
+* Recording several sessions to the same trace file appends them, and the replay plays them back to back.
+* Files that aren't traces are left alone.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "host.h"
+#include "recorder.h"
+#include "event_queue.h"
+
+#define SESSIONS 3
+#define PRESSES 50
+
+static long FileSize(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+/* Records a session of key presses, the recorder is flushed by HostStop */
+static bool RecordSession(const std::string& settings) {
+    if (!HostStart(settings.c_str()))
+        return false;
+    const unsigned long long before = hostNotifications.load();
+    for (unsigned int i = 0; i < PRESSES; i++) {
+        MockGkeyKey(1 + i % LOGITECH_MAX_GKEYS, 1, true);
+        MockGkeyKey(1 + i % LOGITECH_MAX_GKEYS, 1, false);
+    }
+    const bool delivered = HostWaitFor(hostNotifications, before + 2 * PRESSES, 5000);
+    HostStop();
+    return delivered;
+}
+
+int main() {
+    char path[] = "/tmp/gkey_trace_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd == -1)
+        return 1;
+    close(fd);
+
+    const std::string record = std::string("queue_capacity = 0\nrecord_file = ") + path + "\n";
+    for (unsigned int session = 0; session < SESSIONS; session++)
+        HostCheck(RecordSession(record), "every recorded key event is notified");
+
+    const long expected = (long)(sizeof(TraceHeader) + SESSIONS * (1 + 2 * PRESSES) * sizeof(GkeyEvent));
+    HostCheck(FileSize(path) == expected, "every session is appended with a single header");
+
+    /* Sessions are replayed back to back without their session markers */
+    const std::string replay = std::string("queue_capacity = 0\nreplay_file = ") + path + "\n";
+    const unsigned long long before = hostNotifications.load();
+    const uint64_t start = HostTimestamp();
+    if (HostStart(replay.c_str())) {
+        HostCheck(HostWaitFor(hostNotifications, before + SESSIONS * 2 * PRESSES, 5000), "every session is replayed");
+        HostCheck(HostTimestamp() - start < 1000000000ull, "the time between sessions is skipped");
+        HostStop();
+    }
+    HostCheck(hostNotifications.load() == before + SESSIONS * 2 * PRESSES, "session markers aren't replayed");
+
+    /* A file that isn't a trace must not be appended to */
+    FILE* file = fopen(path, "wb");
+    fputs("not a trace file\n", file);
+    fclose(file);
+    const long size = FileSize(path);
+    if (HostStart(record.c_str()))
+        HostStop();
+    HostCheck(FileSize(path) == size, "other files are left alone");
+
+    unlink(path);
+    return HostExitCode();
+}
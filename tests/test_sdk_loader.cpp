@@ -0,0 +1,82 @@
+/*
+* Loading the plugin while the Logitech software isn't running. ts3plugin_init must not wait for the G-key SDK,
+* keys are shown by their identifiers until it comes up, the initialization is retried with backoff, and
+* unloading the plugin cancels a pending initialization.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "ts3_functions.h"
+#include "plugin.h"
+#include "host.h"
+
+#define MS 1000000ULL
+
+/* Loads the plugin without HostRegister, which would wait for the SDK */
+static bool LoadWithoutSdk() {
+    MockGkeySetAvailable(false);
+    const uint64_t start = HostTimestamp();
+    if (!HostInit("queue_capacity = 0\n"))
+        return false;
+    ts3plugin_registerPluginID("gkey_plugin_host");
+    const uint64_t elapsed = HostTimestamp() - start;
+
+    printf("Loading without the Logitech software took %lluus\n", (unsigned long long)(elapsed / 1000));
+    HostCheck(elapsed < 50 * MS, "loading doesn't wait for the Logitech software");
+    return true;
+}
+
+static void LaterAvailable() {
+    const unsigned int calls = MockGkeyInitCalls();
+    if (!LoadWithoutSdk())
+        return;
+    HostCheck(strcmp(ts3plugin_displayKeyText("keybd-g1-m1"), "keybd-g1-m1") == 0,
+        "keys are shown by their identifier until the SDK is ready");
+
+    /* Attempts at 0, 250 and 750ms, retrying without a backoff would have made many more */
+    std::this_thread::sleep_for(std::chrono::milliseconds(900));
+    const unsigned int attempts = MockGkeyInitCalls() - calls;
+    printf("%u attempts while the Logitech software wasn't running\n", attempts);
+    HostCheck(attempts >= 2 && attempts <= 4, "the initialization is retried with backoff");
+
+    MockGkeySetAvailable(true);
+    const uint64_t available = HostTimestamp();
+    HostCheck(MockGkeyWaitReady(5000), "the SDK is initialized once the Logitech software runs");
+    printf("SDK ready %llums after the Logitech software started\n", (unsigned long long)((HostTimestamp() - available) / MS));
+    HostCheck(strcmp(ts3plugin_displayKeyText("keybd-g1-m1"), "G1/M1 \xE2\x8C\x98") == 0,
+        "the SDK names are shown once it is ready");
+
+    const unsigned long long before = hostNotifications.load();
+    MockGkeyKey(1, 1, true);
+    MockGkeyKey(1, 1, false);
+    HostCheck(HostWaitFor(hostNotifications, before + 2, 5000), "key events are notified once the SDK is ready");
+    HostCommand("stats", "Startup:");
+    HostStop();
+}
+
+static void StopWhilePending() {
+    const unsigned int calls = MockGkeyInitCalls();
+    if (!LoadWithoutSdk())
+        return;
+    const uint64_t deadline = HostTimestamp() + 5000 * MS;
+    while (MockGkeyInitCalls() == calls && HostTimestamp() < deadline)
+        std::this_thread::yield();
+
+    const uint64_t start = HostTimestamp();
+    HostStop();
+    const uint64_t elapsed = HostTimestamp() - start;
+    printf("Unloading with a pending initialization took %lluus\n", (unsigned long long)(elapsed / 1000));
+    HostCheck(elapsed < 100 * MS, "unloading doesn't wait for the next attempt");
+
+    const unsigned int stopped = MockGkeyInitCalls();
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    HostCheck(MockGkeyInitCalls() == stopped, "no attempts are made after unloading");
+    MockGkeySetAvailable(true);
+}
+
+int main() {
+    LaterAvailable();
+    StopWhilePending();
+    return HostExitCode();
+}
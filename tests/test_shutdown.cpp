@@ -0,0 +1,114 @@
+/*
+* Loads and unloads the plugin over and over while an SDK thread keeps calling back, like the Logitech software
+* does when it doesn't wait for its callback to return. No key event may be notified without a plugin ID or
+* after shutdown, and a replay must not start before the plugin ID is registered.
+*
+* Run it under ThreadSanitizer in a separate build to check the handoff between the SDK thread and the plugin:
+*   cmake -S . -B build-tsan -DCMAKE_CXX_FLAGS=-fsanitize=thread && cmake --build build-tsan && build-tsan/tests/test_shutdown
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "ts3_functions.h"
+#include "plugin.h"
+#include "host.h"
+#include "quiescence.h"
+#include "recorder.h"
+#include "event_queue.h"
+
+#define CYCLES 200
+#define REPLAY_EVENTS 1000
+#define GATE_PAIRS 10000000
+
+/* The Logitech software calls back from a single thread of its own */
+static std::atomic<bool> sdkRunning(true);
+static std::atomic<unsigned long long> sdkEvents(0);
+
+static void SdkThread() {
+    for (unsigned int i = 0; sdkRunning.load(std::memory_order_relaxed); i++) {
+        MockGkeyEvent(HostKey(1 + (i / 2) % LOGITECH_MAX_GKEYS, 1, !(i & 1)));
+        sdkEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void StressCycles() {
+    const char* settings[] = {
+        "queue_capacity = 0\n",
+        "queue_capacity = 256\ndebounce_keyboard_ms = 1\n",
+        "queue_capacity = 16\nrepeat = keybd-g1-m1\nchord = keybd-g2-m1 + keybd-g3-m1\n",
+    };
+
+    std::thread sdk(SdkThread);
+    for (unsigned int cycle = 0; cycle < CYCLES; cycle++) {
+        if (!HostStart(settings[cycle % 3]))
+            break;
+        for (unsigned int i = 0; i < 100; i++) {
+            ts3plugin_keyDeviceName("keybd-g1-m1");
+            ts3plugin_displayKeyText("keybd-g2-m1");
+        }
+        HostStop();
+    }
+    sdkRunning.store(false);
+    sdk.join();
+
+    printf("%u load cycles with %llu SDK callbacks, %llu notified\n", CYCLES, sdkEvents.load(), hostNotifications.load());
+    HostCheck(hostNotifications.load() > 0, "callbacks are notified while the plugin is loaded");
+}
+
+static void ReplayBeforeRegistration() {
+    char path[] = "/tmp/gkey_trace_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd == -1)
+        return;
+    const TraceHeader header = { TRACE_MAGIC, TRACE_VERSION };
+    HostCheck(write(fd, &header, sizeof(header)) == sizeof(header), "the trace is written");
+    for (unsigned int i = 0; i < REPLAY_EVENTS; i++) {
+        const GkeyEvent event = { GkeyCodeToRaw(HostKey(1 + (i / 2) % LOGITECH_MAX_GKEYS, 1, !(i & 1))), 0, i * 1000ull };
+        HostCheck(write(fd, &event, sizeof(event)) == sizeof(event), "the trace is written");
+    }
+    close(fd);
+
+    /* The client takes its time between ts3plugin_init and registering the plugin ID */
+    const std::string settings = std::string("queue_capacity = 0\nreplay_realtime = false\nreplay_file = ") + path + "\n";
+    const unsigned long long before = hostNotifications.load();
+    if (HostInit(settings.c_str())) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        HostCheck(hostNotifications.load() == before, "nothing is replayed before the plugin ID is registered");
+        HostRegister();
+        HostCheck(HostWaitFor(hostNotifications, before + REPLAY_EVENTS, 5000), "every replayed event is notified");
+        HostStop();
+    }
+    unlink(path);
+}
+
+/* What every SDK callback pays to pin the plugin state */
+static void BenchGate() {
+    QuiescenceGate gate;
+    gate.open();
+    const uint64_t start = HostTimestamp();
+    for (unsigned int i = 0; i < GATE_PAIRS; i++) {
+        if (gate.enter())
+            gate.leave();
+    }
+    const uint64_t open = HostTimestamp() - start;
+
+    gate.close();
+    const uint64_t closedStart = HostTimestamp();
+    for (unsigned int i = 0; i < GATE_PAIRS; i++) {
+        if (gate.enter())
+            gate.leave();
+    }
+    const uint64_t closed = HostTimestamp() - closedStart;
+    printf("QuiescenceGate: %.2fns per enter/leave, %.2fns per turned away caller\n",
+        (double)open / GATE_PAIRS, (double)closed / GATE_PAIRS);
+}
+
+int main() {
+    StressCycles();
+    ReplayBeforeRegistration();
+    BenchGate();
+    return HostExitCode();
+}
@@ -0,0 +1,74 @@
+/*
+* Timer wheel behaviour that can't be observed through the plugin in reasonable time: scheduling after the
+* wheel sat empty for hours must not make the next advance step through every tick that passed.
+*/
+#include <stdio.h>
+#include "timer_wheel.h"
+
+#define HOUR (3600ULL * 1000000000ULL)
+#define MS 1000000ULL
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static unsigned int expired = 0;
+static uint64_t expiredDeadline = 0;
+
+static void Expire(unsigned int slot, uint64_t deadline) {
+    expired++;
+    expiredDeadline = deadline;
+}
+
+/* Schedules a timer after the wheel was idle and returns the time spent advancing to it */
+static uint64_t AfterIdle(uint64_t idle) {
+    const uint64_t start = 1000 * MS;
+    TimerWheelInit(start);
+    TimerWheelAdvance(start, Expire);
+
+    const uint64_t now = start + idle;
+    const uint64_t deadline = now + 500 * MS + 123;
+    expired = 0;
+    TimerWheelSchedule(7, now, deadline);
+
+    const uint64_t t0 = GkeyTimestamp();
+    uint64_t next = TimerWheelAdvance(deadline - MS, Expire);
+    Check(expired == 0, "timers don't fire early");
+    Check(next != 0 && next <= deadline + MS, "the wheel asks to be advanced again by the deadline");
+    TimerWheelAdvance(deadline + MS, Expire);
+    const uint64_t elapsed = GkeyTimestamp() - t0;
+
+    Check(expired == 1 && expiredDeadline == deadline, "the timer fires once with its deadline");
+    Check(!TimerWheelPending(7), "expired timers aren't pending");
+    return elapsed;
+}
+
+int main() {
+    const uint64_t idles[] = { 0, HOUR, 8 * HOUR, 1000 * HOUR };
+    for (size_t i = 0; i < sizeof(idles) / sizeof(idles[0]); i++) {
+        const uint64_t elapsed = AfterIdle(idles[i]);
+        printf("Idle for %4lluh: advancing to the timer took %lluns\n",
+            (unsigned long long)(idles[i] / HOUR), (unsigned long long)elapsed);
+        Check(elapsed < 1 * MS, "advancing after an idle period doesn't step through the idle ticks");
+    }
+
+    /* A timer rescheduled from its own expiry keeps firing at its interval */
+    TimerWheelInit(0);
+    TimerWheelSchedule(3, 0, 50 * MS);
+    unsigned int fired = 0;
+    for (uint64_t now = 0; now <= 1000 * MS; now += MS) {
+        expired = 0;
+        TimerWheelAdvance(now, Expire);
+        if (expired) {
+            fired++;
+            TimerWheelSchedule(3, expiredDeadline, expiredDeadline + 50 * MS);
+        }
+    }
+    Check(fired == 20, "rescheduled timers fire at their interval");
+    return failures ? 1 : 0;
+}